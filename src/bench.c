@@ -0,0 +1,238 @@
+/* bench.c - Microbenchmark runner and the headless benchmark run */
+#include "bench.h"
+#include "kprintf.h"
+#include "serial.h"
+#include "string.h"
+#include "timer.h"
+#include "klog.h"
+#include "io.h"
+#include "cmdline.h"
+#include "boottime.h"
+#include "interrupt.h"
+#include "shell.h"
+
+#define BENCH_SERIAL_BYTES 4096
+
+/*
+ * One metric per line: "BENCH <name> <value> <unit>". Names are dotted
+ * (subsystem.operation.size) and stable across runs, so the collected
+ * lines can be compared run over run; tools/benchcsv.py turns them into
+ * CSV rows.
+ */
+void bench_metric(const char *name, uint32_t value, const char *unit) {
+    kprintf("BENCH %s %u %s\n", name, value, unit);
+}
+
+/* -------------------------------------------------- */
+/* Registered microbenchmarks                         */
+/* -------------------------------------------------- */
+
+extern const bench_t *const __bench_start[];
+extern const bench_t *const __bench_end[];
+
+/*
+ * rdtsc is not ordered against the instructions around it. lfence (SSE2)
+ * waits for everything before it to complete and stops later work
+ * starting early; without SSE2, cpuid serialises at a higher cost,
+ * which the overhead measurement removes again.
+ */
+static uint64_t bench_tsc(void) {
+    uint32_t low, high;
+
+    if (cpu_has(CPU_FEATURE_SSE2)) {
+        __asm__ volatile ("lfence\n\trdtsc\n\tlfence" : "=a"(low), "=d"(high) : : "memory");
+    } else {
+        uint32_t a, b, c, d;
+        cpuid(0, 0, &a, &b, &c, &d);
+        __asm__ volatile ("rdtsc" : "=a"(low), "=d"(high) : : "memory");
+    }
+    return ((uint64_t)high << 32) | low;
+}
+
+/* One timed call of fn(iters), with interrupts (and so preemption) off */
+static uint32_t bench_sample(const bench_t *bench, uint32_t iters) {
+    uint32_t flags = irq_save();
+    uint64_t start, t;
+
+    start = bench_tsc();
+    bench->fn(iters, bench->arg);
+    t = bench_tsc() - start;
+    irq_restore(flags);
+    return t > 0xFFFFFFFFull ? 0xFFFFFFFFu : (uint32_t)t;
+}
+
+static void bench_sort(uint32_t *v, int n) {
+    for (int i = 1; i < n; i++) {
+        uint32_t x = v[i];
+        int j = i;
+        while (j > 0 && v[j - 1] > x) {
+            v[j] = v[j - 1];
+            j--;
+        }
+        v[j] = x;
+    }
+}
+
+static uint32_t bench_per_iter_x10(uint32_t cycles, uint32_t iters) {
+    return (uint32_t)div64_u32((uint64_t)cycles * 10 + iters / 2, iters);
+}
+
+/*
+ * Measure one benchmark: double the iteration count until a sample
+ * takes BENCH_TARGET_CYCLES, so short operations are not lost in the
+ * timer's own cost, then take BENCH_SAMPLES samples. The cheapest
+ * fn(0) call - fences, call and loop setup - is subtracted from each.
+ *
+ * Returns -1 if BENCH_MAX_ITERS iterations still do not fill a sample:
+ * the body does no measurable work, most likely because the compiler
+ * discarded it (see BENCH_KEEP), and its figures would be noise.
+ */
+int bench_run(const bench_t *bench, bench_result_t *result) {
+    static uint32_t samples[BENCH_SAMPLES];
+    uint32_t iters = 1, overhead = 0xFFFFFFFFu;
+    int filled = 0;
+
+    bench_sample(bench, 1);     /* Warm caches and branch predictors */
+    for (;;) {
+        filled = bench_sample(bench, iters) >= BENCH_TARGET_CYCLES;
+        if (filled || iters == BENCH_MAX_ITERS)
+            break;
+        iters <<= 1;
+    }
+
+    for (int i = 0; i < BENCH_SAMPLES; i++) {
+        uint32_t t = bench_sample(bench, 0);
+        if (t < overhead)
+            overhead = t;
+    }
+
+    for (int i = 0; i < BENCH_SAMPLES; i++) {
+        uint32_t t = bench_sample(bench, iters);
+        samples[i] = t > overhead ? t - overhead : 0;
+    }
+    bench_sort(samples, BENCH_SAMPLES);
+
+    result->iters = iters;
+    result->overhead = overhead;
+    result->min_x10 = bench_per_iter_x10(samples[0], iters);
+    result->median_x10 = bench_per_iter_x10(samples[BENCH_SAMPLES / 2], iters);
+    result->p99_x10 = bench_per_iter_x10(samples[BENCH_SAMPLES * 99 / 100], iters);
+    return filled ? 0 : -1;
+}
+
+static void bench_print_x10(uint32_t x10) {
+    kprintf(" %8u.%u", x10 / 10, x10 % 10);
+}
+
+/* Run every benchmark whose name starts with prefix ("" for all) */
+int bench_run_matching(const char *prefix) {
+    size_t len = strlen(prefix);
+    int count = 0;
+
+    for (const bench_t *const *b = __bench_start; b < __bench_end; b++) {
+        bench_result_t r;
+
+        if (strncmp((*b)->name, prefix, len) != 0)
+            continue;
+        if (count++ == 0)
+            kprintf("%-24s %6s %10s %10s %10s %6s\n", "benchmark", "iters",
+                    "min", "median", "p99", "ovhd");
+        if (bench_run(*b, &r) != 0) {
+            kprintf("%-24s %6u  FAILED: no measurable work\n", (*b)->name, r.iters);
+            continue;
+        }
+        kprintf("%-24s %6u", (*b)->name, r.iters);
+        bench_print_x10(r.min_x10);
+        bench_print_x10(r.median_x10);
+        bench_print_x10(r.p99_x10);
+        kprintf(" %6u\n", r.overhead);
+    }
+    if (count)
+        kprintf("(cycles per iteration)\n");
+    return count;
+}
+
+static int bench_command(int argc, char **argv) {
+    const char *prefix = argc > 1 ? argv[1] : "";
+
+    if (argc > 2)
+        return SHELL_USAGE;
+    if (bench_run_matching(prefix) == 0)
+        kprintf("No benchmark matches '%s'\n", prefix);
+    return SHELL_OK;
+}
+SHELL_COMMAND("bench", bench_command, "[name prefix]", "Run microbenchmarks");
+
+/*
+ * Median as the metric, p99 alongside it as <name>.p99. A failed
+ * benchmark is reported as a BENCH-ERROR line instead; returns how many.
+ */
+static int bench_registered_metrics(void) {
+    char name[48];
+    int failed = 0;
+
+    for (const bench_t *const *b = __bench_start; b < __bench_end; b++) {
+        bench_result_t r;
+
+        if (bench_run(*b, &r) != 0) {
+            kprintf("BENCH-ERROR %s no measurable work in %u iterations\n",
+                    (*b)->name, r.iters);
+            failed++;
+            continue;
+        }
+        bench_metric((*b)->name, (r.median_x10 + 5) / 10, "cycles");
+        ksnprintf(name, sizeof(name), "%s.p99", (*b)->name);
+        bench_metric(name, (r.p99_x10 + 5) / 10, "cycles");
+    }
+    return failed;
+}
+
+/* Bulk throughput to the trace port, when QEMU provides a second UART */
+static void bench_serial(void) {
+    static uint8_t data[64];
+
+    if (!serial_port_present(SERIAL_TRACE))
+        return;
+    memset(data, 'x', sizeof(data));
+
+    uint64_t start = rdtsc();
+    for (int i = 0; i < BENCH_SERIAL_BYTES / 64; i++)
+        serial_port_write(SERIAL_TRACE, (const char *)data, sizeof(data));
+    serial_port_flush(SERIAL_TRACE);
+    uint32_t us = timer_cycles_to_us(rdtsc() - start);
+
+    bench_metric("serial.trace_write", (uint32_t)div64_u32(
+                 (uint64_t)BENCH_SERIAL_BYTES * 1000000, us ? us : 1), "bytes/s");
+}
+
+/* Run every registered benchmark; returns the number that failed */
+int bench_run_headless(void) {
+    int failed;
+
+    klog_sync();
+    kprintf("BENCH-BEGIN\n");
+    kprintf("BENCH-ARGS %s\n", cmdline_get());
+    bench_metric("cpu.tsc_khz", timer_tsc_khz(), "kHz");
+    bench_metric("cpu.sse2", string_sse2_active(), "bool");
+    bench_metric("cpu.ermsb", cpu_has(CPU_FEATURE_ERMSB), "bool");
+    boottime_metrics();
+
+    failed = bench_registered_metrics();
+    bench_serial();
+
+    kprintf("BENCH-END\n");
+    return failed;
+}
+
+/*
+ * Leave QEMU through the isa-debug-exit device. Without one (real
+ * hardware, or QEMU run without the device) the write is ignored and the
+ * CPU halts instead.
+ */
+void qemu_exit(uint8_t status) {
+    klog_sync();
+    serial_flush();
+    outb(QEMU_DEBUG_EXIT_PORT, status);
+    for (;;)
+        __asm__ volatile ("cli; hlt");
+}
@@ -0,0 +1,56 @@
+/* bench.h - Microbenchmark registry and the headless benchmark run */
+#ifndef BENCH_H
+#define BENCH_H
+
+#include "types.h"
+#include "cpu.h"
+
+/* QEMU isa-debug-exit: writing v makes QEMU exit with status (v << 1) | 1 */
+#define QEMU_DEBUG_EXIT_PORT  0xF4
+
+/* Microbenchmark registry: BENCH() descriptors live in the .bench section */
+#define BENCH_SAMPLES        128       /* Timed samples per benchmark */
+#define BENCH_TARGET_CYCLES  20000     /* Calibrated length of one sample */
+#define BENCH_MAX_ITERS      65536
+
+typedef struct {
+    const char *name;                           /* Dotted: subsystem.operation[.size] */
+    void (*fn)(uint32_t iters, uint32_t arg);   /* Run the operation iters times */
+    uint32_t arg;
+} bench_t;
+
+/* Cycles per iteration in tenths, after harness overhead */
+typedef struct {
+    uint32_t iters;
+    uint32_t min_x10;
+    uint32_t median_x10;
+    uint32_t p99_x10;
+    uint32_t overhead;      /* Cycles per sample subtracted */
+} bench_result_t;
+
+/* Registers fn(iters, arg) with a fixed argument, e.g. a block size */
+#define BENCH_REGISTER(id, name, fn, arg)                                    \
+    static const bench_t bench_desc_##id = { name, fn, arg };                \
+    static const bench_t *const bench_ptr_##id                              \
+        __attribute__((section(".bench"), used)) = &bench_desc_##id
+
+/*
+ * Define and register a benchmark body that runs its operation 'iters'
+ * times:  BENCH(heap_small, "heap.alloc_free.64") { for (...) ...; }
+ */
+#define BENCH(id, name)                                                      \
+    static void bench_fn_##id(uint32_t iters, uint32_t arg);                 \
+    BENCH_REGISTER(id, name, bench_fn_##id, 0);                              \
+    static void bench_fn_##id(uint32_t iters, uint32_t arg __attribute__((unused)))
+
+/* Stop the compiler from discarding a result the benchmark ignores */
+#define BENCH_KEEP(value)  __asm__ volatile ("" : : "g"(value) : "memory")
+
+int bench_run(const bench_t *bench, bench_result_t *result);
+int bench_run_matching(const char *prefix);
+
+void bench_metric(const char *name, uint32_t value, const char *unit);
+int bench_run_headless(void);
+void qemu_exit(uint8_t status) __attribute__((noreturn));
+
+#endif
@@ -0,0 +1,145 @@
+/* benchmarks.c - Kernel microbenchmarks registered with BENCH() */
+#include "bench.h"
+#include "string.h"
+#include "memory.h"
+#include "kprintf.h"
+
+#define BENCH_BLOCK_MAX  16384
+
+static uint8_t block_a[BENCH_BLOCK_MAX] __attribute__((aligned(16)));
+static uint8_t block_b[BENCH_BLOCK_MAX] __attribute__((aligned(16)));
+
+/*
+ * Both blocks hold 'x' bytes and block_a ends in the terminator strlen
+ * stops at. Filled on first use (the runner's warm-up call); the memset
+ * and memcpy benchmarks only ever store the same contents again.
+ */
+static void blocks_fill(void) {
+    static int filled;
+
+    if (filled)
+        return;
+    filled = 1;
+    memset(block_a, 'x', BENCH_BLOCK_MAX);
+    memset(block_b, 'x', BENCH_BLOCK_MAX);
+    block_a[BENCH_BLOCK_MAX - 1] = '\0';
+}
+
+/* -------------------------------------------------- */
+/* string.c: fixed-size blocks                        */
+/* -------------------------------------------------- */
+
+static void bench_memset(uint32_t iters, uint32_t n) {
+    while (iters--)
+        memset(block_b, 'x', n);
+}
+
+static void bench_memcpy(uint32_t iters, uint32_t n) {
+    blocks_fill();
+    while (iters--)
+        memcpy(block_b, block_a, n);
+}
+
+static void bench_memcmp(uint32_t iters, uint32_t n) {
+    blocks_fill();
+    while (iters--)
+        BENCH_KEEP(memcmp(block_a, block_b, n));
+}
+
+static void bench_strlen(uint32_t iters, uint32_t n) {
+    blocks_fill();
+    while (iters--)
+        BENCH_KEEP(strlen((const char *)block_a + BENCH_BLOCK_MAX - n));
+}
+
+/* The same operations with the SSE2 versions switched off */
+#define BENCH_SCALAR(op)                                                     \
+    static void bench_##op##_scalar(uint32_t iters, uint32_t n) {            \
+        int sse2 = string_sse2_active();                                     \
+        string_use_sse2(0);                                                  \
+        bench_##op(iters, n);                                                \
+        string_use_sse2(sse2);                                               \
+    }
+
+BENCH_SCALAR(memset)
+BENCH_SCALAR(memcpy)
+BENCH_SCALAR(memcmp)
+BENCH_SCALAR(strlen)
+
+/* Byte-at-a-time references for memset/memcpy; kept as loops, not calls */
+__attribute__((noinline, optimize("no-tree-loop-distribute-patterns")))
+static void bench_byte_set(uint32_t iters, uint32_t n) {
+    while (iters--) {
+        uint8_t *p = block_b;
+        for (uint32_t i = 0; i < n; i++)
+            *p++ = 'x';
+        BENCH_KEEP(block_b);
+    }
+}
+
+__attribute__((noinline, optimize("no-tree-loop-distribute-patterns")))
+static void bench_byte_copy(uint32_t iters, uint32_t n) {
+    blocks_fill();
+    while (iters--) {
+        uint8_t *d = block_b;
+        const uint8_t *s = block_a;
+        for (uint32_t i = 0; i < n; i++)
+            *d++ = *s++;
+        BENCH_KEEP(block_b);
+    }
+}
+
+BENCH_REGISTER(memset_64, "string.memset.64", bench_memset, 64);
+BENCH_REGISTER(memset_1k, "string.memset.1024", bench_memset, 1024);
+BENCH_REGISTER(memset_16k, "string.memset.16384", bench_memset, BENCH_BLOCK_MAX);
+BENCH_REGISTER(memcpy_64, "string.memcpy.64", bench_memcpy, 64);
+BENCH_REGISTER(memcpy_1k, "string.memcpy.1024", bench_memcpy, 1024);
+BENCH_REGISTER(memcpy_16k, "string.memcpy.16384", bench_memcpy, BENCH_BLOCK_MAX);
+BENCH_REGISTER(memcmp_64, "string.memcmp.64", bench_memcmp, 64);
+BENCH_REGISTER(memcmp_1k, "string.memcmp.1024", bench_memcmp, 1024);
+BENCH_REGISTER(memcmp_16k, "string.memcmp.16384", bench_memcmp, BENCH_BLOCK_MAX);
+BENCH_REGISTER(strlen_64, "string.strlen.64", bench_strlen, 64);
+BENCH_REGISTER(strlen_1k, "string.strlen.1024", bench_strlen, 1024);
+BENCH_REGISTER(strlen_16k, "string.strlen.16384", bench_strlen, BENCH_BLOCK_MAX);
+BENCH_REGISTER(memset_scalar_64, "string.memset_scalar.64", bench_memset_scalar, 64);
+BENCH_REGISTER(memset_scalar_1k, "string.memset_scalar.1024", bench_memset_scalar, 1024);
+BENCH_REGISTER(memset_scalar_16k, "string.memset_scalar.16384", bench_memset_scalar, BENCH_BLOCK_MAX);
+BENCH_REGISTER(memcpy_scalar_64, "string.memcpy_scalar.64", bench_memcpy_scalar, 64);
+BENCH_REGISTER(memcpy_scalar_1k, "string.memcpy_scalar.1024", bench_memcpy_scalar, 1024);
+BENCH_REGISTER(memcpy_scalar_16k, "string.memcpy_scalar.16384", bench_memcpy_scalar, BENCH_BLOCK_MAX);
+BENCH_REGISTER(memcmp_scalar_64, "string.memcmp_scalar.64", bench_memcmp_scalar, 64);
+BENCH_REGISTER(memcmp_scalar_1k, "string.memcmp_scalar.1024", bench_memcmp_scalar, 1024);
+BENCH_REGISTER(memcmp_scalar_16k, "string.memcmp_scalar.16384", bench_memcmp_scalar, BENCH_BLOCK_MAX);
+BENCH_REGISTER(strlen_scalar_64, "string.strlen_scalar.64", bench_strlen_scalar, 64);
+BENCH_REGISTER(strlen_scalar_1k, "string.strlen_scalar.1024", bench_strlen_scalar, 1024);
+BENCH_REGISTER(strlen_scalar_16k, "string.strlen_scalar.16384", bench_strlen_scalar, BENCH_BLOCK_MAX);
+BENCH_REGISTER(byte_set_64, "string.byte_set.64", bench_byte_set, 64);
+BENCH_REGISTER(byte_set_1k, "string.byte_set.1024", bench_byte_set, 1024);
+BENCH_REGISTER(byte_set_16k, "string.byte_set.16384", bench_byte_set, BENCH_BLOCK_MAX);
+BENCH_REGISTER(byte_copy_64, "string.byte_copy.64", bench_byte_copy, 64);
+BENCH_REGISTER(byte_copy_1k, "string.byte_copy.1024", bench_byte_copy, 1024);
+BENCH_REGISTER(byte_copy_16k, "string.byte_copy.16384", bench_byte_copy, BENCH_BLOCK_MAX);
+
+BENCH(strcmp_20, "string.strcmp.20") {
+    static const char *volatile a = "process_list_display";
+    static const char *volatile b = "process_list_displax";
+
+    while (iters--)
+        BENCH_KEEP(strcmp(a, b));
+}
+
+/* -------------------------------------------------- */
+/* Heap and formatting                                */
+/* -------------------------------------------------- */
+
+BENCH(heap_small, "heap.alloc_free.64") {
+    while (iters--)
+        memory_deallocate(memory_allocate(64));
+}
+
+BENCH(ksnprintf, "kprintf.ksnprintf") {
+    char buf[64];
+
+    while (iters--)
+        BENCH_KEEP(ksnprintf(buf, sizeof(buf), "pid %d state %s at %x", 7, "READY", 0xC0FFEE));
+}
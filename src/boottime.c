@@ -0,0 +1,76 @@
+/* boottime.c - Boot phase timestamps from start to the shell prompt */
+#include "boottime.h"
+#include "cpu.h"
+#include "timer.h"
+#include "kprintf.h"
+#include "bench.h"
+#include "shell.h"
+
+/* Written by boot.S before and after clearing .bss, so kept in .data */
+extern uint64_t boot_tsc_entry;
+extern uint64_t boot_tsc_bss;
+
+typedef struct {
+    const char *name;
+    uint64_t tsc;
+} boot_phase_t;
+
+static boot_phase_t phases[BOOT_PHASES_MAX];
+static int phase_count;
+
+/*
+ * Record the end of a boot phase. Each phase is charged the cycles since
+ * the previous mark; the first follows the BSS clear in boot.S.
+ */
+void boottime_mark(const char *phase) {
+    if (phase_count < BOOT_PHASES_MAX) {
+        phases[phase_count].name = phase;
+        phases[phase_count].tsc = rdtsc();
+        phase_count++;
+    }
+}
+
+/* TSC values become microseconds once timer_calibrate_tsc() has run */
+static uint32_t phase_us(uint64_t from, uint64_t to) {
+    return timer_tsc_khz() ? timer_cycles_to_us(to - from) : 0;
+}
+
+static void report_line(const char *name, uint64_t from, uint64_t to) {
+    kprintf("%-20s %10llu %8u %8u\n", name, to - from,
+            phase_us(from, to), phase_us(boot_tsc_entry, to));
+}
+
+void boottime_report(void) {
+    uint64_t prev = boot_tsc_bss;
+
+    kprintf("%-20s %10s %8s %8s\n", "phase", "cycles", "us", "total us");
+    kprintf("%-20s %10s %8u\n", "firmware+loader", "", phase_us(0, boot_tsc_entry));
+    report_line("bss_clear", boot_tsc_entry, boot_tsc_bss);
+    for (int i = 0; i < phase_count; i++) {
+        report_line(phases[i].name, prev, phases[i].tsc);
+        prev = phases[i].tsc;
+    }
+}
+
+/* The same figures as BENCH lines for make bench-qemu */
+void boottime_metrics(void) {
+    uint64_t prev = boot_tsc_bss;
+    char name[40];
+
+    bench_metric("boot.bss_clear", phase_us(boot_tsc_entry, boot_tsc_bss), "us");
+    for (int i = 0; i < phase_count; i++) {
+        ksnprintf(name, sizeof(name), "boot.%s", phases[i].name);
+        bench_metric(name, phase_us(prev, phases[i].tsc), "us");
+        prev = phases[i].tsc;
+    }
+    if (phase_count)
+        bench_metric("boot.total", phase_us(boot_tsc_entry, prev), "us");
+}
+
+static int boottime_command(int argc, char **argv) {
+    (void)argc;
+    (void)argv;
+    boottime_report();
+    return SHELL_OK;
+}
+SHELL_COMMAND("boottime", boottime_command, NULL, "Time spent in each boot phase");
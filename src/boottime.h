@@ -0,0 +1,13 @@
+/* boottime.h - Boot phase timestamps */
+#ifndef BOOTTIME_H
+#define BOOTTIME_H
+
+#include "types.h"
+
+#define BOOT_PHASES_MAX 24
+
+void boottime_mark(const char *phase);
+void boottime_report(void);
+void boottime_metrics(void);
+
+#endif
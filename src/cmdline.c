@@ -0,0 +1,162 @@
+/* cmdline.c - Kernel command line parsing */
+#include "cmdline.h"
+#include "string.h"
+#include "memory.h"
+#include "process.h"
+#include "timer.h"
+#include "klog.h"
+
+boot_config_t boot_config = {
+    .heap_size = DEFAULT_HEAP_SIZE,
+    .max_procs = DEFAULT_MAX_PROCS,
+    .proc_stack_size = DEFAULT_PROC_STACK_SIZE,
+    .timer_hz = TIMER_HZ,
+    .sched_policy = SCHED_PRIORITY,
+    .bench = 0,
+    .mem_upper_kb = 0,
+};
+
+/* Private copy: the loader's string sits in memory the heap may reuse */
+static char cmdline[CMDLINE_MAX];
+
+/* Decimal or 0x-prefixed hex, with an optional K or M multiplier */
+int cmdline_parse_number(const char *s, uint32_t *out) {
+    uint32_t base = 10, value = 0;
+    int digits = 0;
+
+    if (s[0] == '0' && (s[1] == 'x' || s[1] == 'X')) {
+        base = 16;
+        s += 2;
+    }
+    for (;; s++, digits++) {
+        uint32_t d;
+        if (*s >= '0' && *s <= '9')
+            d = *s - '0';
+        else if (base == 16 && *s >= 'a' && *s <= 'f')
+            d = *s - 'a' + 10;
+        else if (base == 16 && *s >= 'A' && *s <= 'F')
+            d = *s - 'A' + 10;
+        else
+            break;
+        if (value > (0xFFFFFFFFu - d) / base)
+            return -1;
+        value = value * base + d;
+    }
+    if (digits == 0)
+        return -1;
+
+    uint32_t shift = 0;
+    if (*s == 'K' || *s == 'k')
+        shift = 10;
+    else if (*s == 'M' || *s == 'm')
+        shift = 20;
+    if (shift) {
+        if (value > (0xFFFFFFFFu >> shift))
+            return -1;
+        value <<= shift;
+        s++;
+    }
+    if (*s)
+        return -1;
+    *out = value;
+    return 0;
+}
+
+/* Numeric option with inclusive bounds; out-of-range values keep the default */
+static void set_number(const char *key, const char *value, uint32_t *field,
+                       uint32_t min, uint32_t max) {
+    uint32_t n;
+
+    if (!value || cmdline_parse_number(value, &n) != 0) {
+        klog(KLOG_WARN, "cmdline: %s needs a number", key);
+    } else if (n < min || n > max) {
+        klog(KLOG_WARN, "cmdline: %s=%u outside %u..%u, keeping %u",
+             key, n, min, max, *field);
+    } else {
+        *field = n;
+    }
+}
+
+static void parse_option(char *key) {
+    char *value = NULL;
+
+    for (char *p = key; *p; p++) {
+        if (*p == '=') {
+            *p = '\0';
+            value = p + 1;
+            break;
+        }
+    }
+
+    if (strcmp(key, "heap") == 0) {
+        set_number(key, value, &boot_config.heap_size, HEAP_SIZE_MIN, HEAP_SIZE_MAX);
+    } else if (strcmp(key, "procs") == 0) {
+        set_number(key, value, &boot_config.max_procs, PROC_LIMIT_MIN, MAX_PROCS);
+    } else if (strcmp(key, "stack") == 0) {
+        set_number(key, value, &boot_config.proc_stack_size,
+                   PROC_STACK_SIZE_MIN, PROC_STACK_SIZE_MAX);
+    } else if (strcmp(key, "hz") == 0) {
+        set_number(key, value, &boot_config.timer_hz, TIMER_HZ_MIN, TIMER_HZ_MAX);
+    } else if (strcmp(key, "sched") == 0) {
+        if (value && strcmp(value, "prio") == 0)
+            boot_config.sched_policy = SCHED_PRIORITY;
+        else if (value && strcmp(value, "rr") == 0)
+            boot_config.sched_policy = SCHED_ROUND_ROBIN;
+        else
+            klog(KLOG_WARN, "cmdline: sched must be prio or rr");
+    } else if (strcmp(key, "bench") == 0) {
+        boot_config.bench = 1;
+    } else {
+        klog(KLOG_WARN, "cmdline: unknown option '%s'", key);
+    }
+}
+
+/*
+ * Copy the multiboot command line and apply its space-separated options
+ * to boot_config. Runs before the heap exists, so this must be called
+ * early in kmain; without a multiboot loader the defaults stand.
+ * QEMU and GRUB put the kernel image path first; that word is skipped.
+ */
+void cmdline_initialize(uint32_t magic, const multiboot_info_t *mbi) {
+    if (magic != MULTIBOOT_BOOTLOADER_MAGIC || !mbi) {
+        klog(KLOG_WARN, "cmdline: not booted by multiboot (magic %x)", magic);
+        return;
+    }
+    if (mbi->flags & MULTIBOOT_INFO_MEMORY)
+        boot_config.mem_upper_kb = mbi->mem_upper;
+    if (!(mbi->flags & MULTIBOOT_INFO_CMDLINE))
+        return;
+
+    const char *line = (const char *)mbi->cmdline;
+    while (*line && *line != ' ')
+        line++;
+    while (*line == ' ')
+        line++;
+    strncpy(cmdline, line, CMDLINE_MAX - 1);
+
+    /* Tokenise a scratch copy so cmdline_get() keeps the original */
+    char options[CMDLINE_MAX];
+    char *p = options;
+
+    strcpy(options, cmdline);
+    while (*p) {
+        while (*p == ' ')
+            p++;
+        if (!*p)
+            break;
+        char *token = p;
+        while (*p && *p != ' ')
+            p++;
+        if (*p)
+            *p++ = '\0';
+        parse_option(token);
+    }
+
+    if (cmdline[0])
+        klog(KLOG_INFO, "Command line: %s", cmdline);
+}
+
+/* Options after the image path, as given to the loader */
+const char *cmdline_get(void) {
+    return cmdline;
+}
@@ -0,0 +1,27 @@
+/* cmdline.h - Kernel command line and boot-time settings */
+#ifndef CMDLINE_H
+#define CMDLINE_H
+
+#include "types.h"
+#include "multiboot.h"
+
+#define CMDLINE_MAX 256
+
+/* Settings the command line can override; defaults are the old constants */
+typedef struct {
+    uint32_t heap_size;         /* heap=      bytes, K/M suffix allowed */
+    uint32_t max_procs;         /* procs=     process table slots in use */
+    uint32_t proc_stack_size;   /* stack=     per-process stack bytes */
+    uint32_t timer_hz;          /* hz=        PIT tick rate */
+    int sched_policy;           /* sched=     prio | rr */
+    int bench;                  /* bench      run the benchmark set and exit */
+    uint32_t mem_upper_kb;      /* From the loader: KB above 1 MB, 0 if unknown */
+} boot_config_t;
+
+extern boot_config_t boot_config;
+
+void cmdline_initialize(uint32_t magic, const multiboot_info_t *mbi);
+const char *cmdline_get(void);
+int cmdline_parse_number(const char *s, uint32_t *out);
+
+#endif
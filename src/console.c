@@ -0,0 +1,31 @@
+/* console.c - Console input merged from COM1 and the PS/2 keyboard */
+#include "console.h"
+#include "serial.h"
+#include "keyboard.h"
+#include "interrupt.h"
+#include "process.h"
+
+/*
+ * Return the next character from whichever input has one. Both drivers
+ * raise EVENT_CONSOLE_INPUT, so a blocked process wakes for either; on
+ * the boot stack any interrupt ends the halt and both are checked again.
+ */
+char console_getc(void) {
+    uint32_t flags = irq_save();
+    int c;
+
+    for (;;) {
+        c = serial_port_try_getc(SERIAL_CONSOLE);
+        if (c < 0)
+            c = keyboard_try_getc();
+        if (c >= 0)
+            break;
+
+        if (process_can_block())
+            process_wait_event(EVENT_CONSOLE_INPUT);
+        else
+            process_idle_wait();
+    }
+    irq_restore(flags);
+    return (char)c;
+}
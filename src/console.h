@@ -0,0 +1,7 @@
+/* console.h - Console input from serial and keyboard */
+#ifndef CONSOLE_H
+#define CONSOLE_H
+
+char console_getc(void);
+
+#endif
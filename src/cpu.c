@@ -0,0 +1,91 @@
+/* cpu.c - CPUID feature detection */
+#include "cpu.h"
+#include "initcall.h"
+
+#define EFLAGS_ID 0x00200000
+
+#define CR0_MP          0x00000002   /* Monitor coprocessor */
+#define CR0_EM          0x00000004   /* x87 emulation: must be clear for SSE */
+#define CR4_OSFXSR      0x00000200   /* OS supports FXSAVE/FXRSTOR */
+#define CR4_OSXMMEXCPT  0x00000400   /* OS handles SIMD exceptions (#XM) */
+
+static uint32_t features = 0;
+
+/* CPUID exists if the ID bit in EFLAGS can be toggled */
+static int cpuid_supported(void) {
+    uint32_t before, after;
+    __asm__ volatile ("pushfl\n\t"
+                      "popl %0\n\t"
+                      "movl %0, %1\n\t"
+                      "xorl %2, %1\n\t"
+                      "pushl %1\n\t"
+                      "popfl\n\t"
+                      "pushfl\n\t"
+                      "popl %1\n\t"
+                      "pushl %0\n\t"
+                      "popfl"
+                      : "=&r"(before), "=&r"(after)
+                      : "i"(EFLAGS_ID));
+    return ((before ^ after) & EFLAGS_ID) != 0;
+}
+
+void cpu_detect_features(void) {
+    uint32_t max_leaf, eax, ebx, ecx, edx;
+
+    features = 0;
+    if (!cpuid_supported())
+        return;
+
+    cpuid(0, 0, &max_leaf, &ebx, &ecx, &edx);
+
+    if (max_leaf >= 1) {
+        cpuid(1, 0, &eax, &ebx, &ecx, &edx);
+        if (edx & (1 << 4))  features |= CPU_FEATURE_TSC;
+        if (edx & (1 << 25)) features |= CPU_FEATURE_SSE;
+        if (edx & (1 << 26)) features |= CPU_FEATURE_SSE2;
+    }
+    if (max_leaf >= 7) {
+        cpuid(7, 0, &eax, &ebx, &ecx, &edx);
+        if (ebx & (1 << 9))  features |= CPU_FEATURE_ERMSB;
+        if (edx & (1 << 4))  features |= CPU_FEATURE_FSRM;
+    }
+}
+
+int cpu_has(uint32_t feature) {
+    return (features & feature) == feature;
+}
+
+uint32_t cpu_features(void) {
+    return features;
+}
+
+static int cpu_init(void) {
+    cpu_detect_features();
+    return 0;
+}
+INITCALL("cpu", cpu_init, INIT_LEVEL_CPU, NULL);
+
+/*
+ * Make SSE instructions usable: clear CR0.EM, set CR0.MP, and advertise
+ * FXSAVE and #XM support in CR4. XMM registers are not saved on a context
+ * switch, so code using them must keep interrupts off while it does.
+ * Returns 1 and sets CPU_FEATURE_XMM on success.
+ */
+int cpu_enable_sse(void) {
+    uint32_t cr0, cr4;
+
+    if (!cpu_has(CPU_FEATURE_SSE | CPU_FEATURE_SSE2))
+        return 0;
+
+    __asm__ volatile ("movl %%cr0, %0" : "=r"(cr0));
+    cr0 = (cr0 & ~CR0_EM) | CR0_MP;
+    __asm__ volatile ("movl %0, %%cr0" : : "r"(cr0));
+
+    __asm__ volatile ("movl %%cr4, %0" : "=r"(cr4));
+    cr4 |= CR4_OSFXSR | CR4_OSXMMEXCPT;
+    __asm__ volatile ("movl %0, %%cr4" : : "r"(cr4));
+
+    __asm__ volatile ("fninit");
+    features |= CPU_FEATURE_XMM;
+    return 1;
+}
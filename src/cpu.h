@@ -0,0 +1,49 @@
+/* cpu.h - CPU feature detection and instruction helpers */
+#ifndef CPU_H
+#define CPU_H
+
+#include "types.h"
+
+/* Feature bits for cpu_has() */
+#define CPU_FEATURE_TSC    0x01
+#define CPU_FEATURE_SSE    0x02
+#define CPU_FEATURE_SSE2   0x04
+#define CPU_FEATURE_ERMSB  0x08   /* Enhanced REP MOVSB/STOSB */
+#define CPU_FEATURE_FSRM   0x10   /* Fast short REP MOVSB */
+#define CPU_FEATURE_XMM    0x20   /* SSE state enabled by cpu_enable_sse() */
+
+void cpu_detect_features(void);
+int cpu_has(uint32_t feature);
+uint32_t cpu_features(void);
+int cpu_enable_sse(void);
+
+static inline void cpuid(uint32_t leaf, uint32_t subleaf, uint32_t *eax,
+                         uint32_t *ebx, uint32_t *ecx, uint32_t *edx) {
+    __asm__ volatile ("cpuid"
+                      : "=a"(*eax), "=b"(*ebx), "=c"(*ecx), "=d"(*edx)
+                      : "a"(leaf), "c"(subleaf));
+}
+
+/* Read the time-stamp counter */
+static inline uint64_t rdtsc(void) {
+    uint32_t low, high;
+    __asm__ volatile ("rdtsc" : "=a"(low), "=d"(high));
+    return ((uint64_t)high << 32) | low;
+}
+
+/*
+ * Divide a 64-bit value by a 32-bit one. The kernel is not linked against
+ * libgcc, so plain '/' on uint64_t (which calls __udivdi3) is unavailable.
+ */
+static inline uint64_t div64_u32(uint64_t n, uint32_t d) {
+    uint32_t high = (uint32_t)(n >> 32);
+    uint32_t low = (uint32_t)n;
+    uint32_t q_high = high / d;
+    uint32_t q_low, rem;
+
+    high %= d;
+    __asm__ ("divl %4" : "=a"(q_low), "=d"(rem) : "a"(low), "d"(high), "rm"(d));
+    return ((uint64_t)q_high << 32) | q_low;
+}
+
+#endif
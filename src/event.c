@@ -0,0 +1,312 @@
+/* event.c - Event sources, counters, timers and poll-style interest sets */
+#include "event.h"
+#include "process.h"
+#include "interrupt.h"
+
+typedef enum {
+    EVOBJ_FREE,
+    EVOBJ_SOURCE,       /* Driver-owned, readiness via callback */
+    EVOBJ_COUNTER,      /* Ready while count > 0 */
+    EVOBJ_TIMER         /* Counter bumped every 'period' ticks */
+} evobj_type_t;
+
+typedef struct {
+    evobj_type_t type;
+    int event_id;
+    event_ready_fn ready;
+    int arg;
+    volatile uint32_t count;
+    uint32_t period;
+    uint32_t remaining;
+} event_object_t;
+
+typedef struct {
+    int in_use;
+    int count;
+    int event_ids[EVENT_SET_SIZE];
+    uint32_t data[EVENT_SET_SIZE];
+    volatile int waiting;               /* Someone is blocked in event_set_wait() */
+    volatile int timeout_remaining;     /* Ticks left, or -1 for none */
+    volatile int timed_out;
+} event_set_t;
+
+static event_object_t objects[EVENT_MAX_OBJECTS];
+static event_set_t sets[EVENT_MAX_SETS];
+
+/* -------------------------------------------------- */
+/* Objects                                            */
+/* -------------------------------------------------- */
+
+static event_object_t *event_find(int event_id) {
+    int slot = event_id - EVENT_OBJECT_BASE;
+    if (slot >= 0 && slot < EVENT_MAX_OBJECTS && objects[slot].type != EVOBJ_FREE &&
+        objects[slot].event_id == event_id)
+        return &objects[slot];
+
+    for (int i = 0; i < EVENT_MAX_OBJECTS; i++) {
+        if (objects[i].type == EVOBJ_SOURCE && objects[i].event_id == event_id)
+            return &objects[i];
+    }
+    return NULL;
+}
+
+static event_object_t *event_alloc(evobj_type_t type) {
+    for (int i = 0; i < EVENT_MAX_OBJECTS; i++) {
+        if (objects[i].type == EVOBJ_FREE) {
+            objects[i].type = type;
+            objects[i].event_id = EVENT_OBJECT_BASE + i;
+            objects[i].ready = NULL;
+            objects[i].arg = 0;
+            objects[i].count = 0;
+            objects[i].period = 0;
+            objects[i].remaining = 0;
+            return &objects[i];
+        }
+    }
+    return NULL;
+}
+
+static int event_is_ready(int event_id) {
+    event_object_t *obj = event_find(event_id);
+    if (!obj)
+        return 0;
+    if (obj->type == EVOBJ_SOURCE)
+        return obj->ready(obj->arg);
+    return obj->count > 0;
+}
+
+/* Let a driver's existing wakeup event take part in event sets */
+int event_register_source(int event_id, event_ready_fn ready, int arg) {
+    uint32_t flags = irq_save();
+    event_object_t *obj = event_find(event_id);
+
+    if (!obj || obj->type != EVOBJ_SOURCE) {
+        obj = event_alloc(EVOBJ_SOURCE);
+        if (!obj) {
+            irq_restore(flags);
+            return -1;
+        }
+    }
+    obj->event_id = event_id;
+    obj->ready = ready;
+    obj->arg = arg;
+    irq_restore(flags);
+    return 0;
+}
+
+int event_counter_create(void) {
+    uint32_t flags = irq_save();
+    event_object_t *obj = event_alloc(EVOBJ_COUNTER);
+    irq_restore(flags);
+    return obj ? obj->event_id : -1;
+}
+
+/* Add one to a counter and wake anything waiting on it; IRQ safe */
+void event_counter_signal(int event_id) {
+    uint32_t flags = irq_save();
+    event_object_t *obj = event_find(event_id);
+    if (obj && obj->type == EVOBJ_COUNTER) {
+        obj->count++;
+        process_wakeup_event(event_id);
+    }
+    irq_restore(flags);
+}
+
+int event_timer_create(uint32_t period_ticks) {
+    if (period_ticks == 0)
+        return -1;
+
+    uint32_t flags = irq_save();
+    event_object_t *obj = event_alloc(EVOBJ_TIMER);
+    if (obj) {
+        obj->period = period_ticks;
+        obj->remaining = period_ticks;
+    }
+    irq_restore(flags);
+    return obj ? obj->event_id : -1;
+}
+
+/* Consume a counter or timer: returns the pending count and resets it */
+uint32_t event_take(int event_id) {
+    uint32_t flags = irq_save();
+    event_object_t *obj = event_find(event_id);
+    uint32_t count = 0;
+    if (obj && obj->type != EVOBJ_SOURCE) {
+        count = obj->count;
+        obj->count = 0;
+    }
+    irq_restore(flags);
+    return count;
+}
+
+void event_close(int event_id) {
+    uint32_t flags = irq_save();
+    event_object_t *obj = event_find(event_id);
+    if (obj)
+        obj->type = EVOBJ_FREE;
+    irq_restore(flags);
+}
+
+/* -------------------------------------------------- */
+/* Interest sets                                      */
+/* -------------------------------------------------- */
+
+static event_set_t *set_get(int set) {
+    if (set < 0 || set >= EVENT_MAX_SETS || !sets[set].in_use)
+        return NULL;
+    return &sets[set];
+}
+
+int event_set_create(void) {
+    uint32_t flags = irq_save();
+    for (int i = 0; i < EVENT_MAX_SETS; i++) {
+        if (!sets[i].in_use) {
+            sets[i].in_use = 1;
+            sets[i].count = 0;
+            sets[i].waiting = 0;
+            sets[i].timeout_remaining = -1;
+            sets[i].timed_out = 0;
+            irq_restore(flags);
+            return i;
+        }
+    }
+    irq_restore(flags);
+    return -1;
+}
+
+void event_set_destroy(int set) {
+    event_set_t *s = set_get(set);
+    if (s)
+        s->in_use = 0;
+}
+
+int event_set_add(int set, int event_id, uint32_t data) {
+    event_set_t *s = set_get(set);
+    if (!s || event_id <= 0 || event_id >= EVENT_SET_BASE)
+        return -1;
+
+    uint32_t flags = irq_save();
+    for (int i = 0; i < s->count; i++) {
+        if (s->event_ids[i] == event_id) {
+            s->data[i] = data;
+            irq_restore(flags);
+            return 0;
+        }
+    }
+    if (s->count == EVENT_SET_SIZE) {
+        irq_restore(flags);
+        return -1;
+    }
+    s->event_ids[s->count] = event_id;
+    s->data[s->count] = data;
+    s->count++;
+    irq_restore(flags);
+    return 0;
+}
+
+int event_set_remove(int set, int event_id) {
+    event_set_t *s = set_get(set);
+    if (!s)
+        return -1;
+
+    uint32_t flags = irq_save();
+    for (int i = 0; i < s->count; i++) {
+        if (s->event_ids[i] == event_id) {
+            s->count--;
+            s->event_ids[i] = s->event_ids[s->count];
+            s->data[i] = s->data[s->count];
+            irq_restore(flags);
+            return 0;
+        }
+    }
+    irq_restore(flags);
+    return -1;
+}
+
+/* Level-triggered scan: report every member that is ready right now */
+static int set_collect(event_set_t *s, event_ready_t *ready, int max_ready) {
+    int n = 0;
+    for (int i = 0; i < s->count && n < max_ready; i++) {
+        if (event_is_ready(s->event_ids[i])) {
+            ready[n].event_id = s->event_ids[i];
+            ready[n].data = s->data[i];
+            n++;
+        }
+    }
+    return n;
+}
+
+/*
+ * Block until at least one member of 'set' is ready, then return up to
+ * 'max_ready' of them in one batch. timeout_ticks of 0 polls, and
+ * EVENT_WAIT_FOREVER never times out. Returns 0 on timeout, -1 on a bad
+ * set. Readiness is level-triggered: counters and timers stay ready until
+ * event_take(), driver sources until their data is read.
+ */
+int event_set_wait(int set, event_ready_t *ready, int max_ready, int timeout_ticks) {
+    event_set_t *s = set_get(set);
+    if (!s || !ready || max_ready <= 0)
+        return -1;
+
+    uint32_t flags = irq_save();
+    int n;
+
+    s->timed_out = 0;
+    s->timeout_remaining = timeout_ticks > 0 ? timeout_ticks : -1;
+    for (;;) {
+        n = set_collect(s, ready, max_ready);
+        if (n > 0 || timeout_ticks == 0 || s->timed_out)
+            break;
+
+        s->waiting = 1;
+        if (process_can_block())
+            process_wait_event(EVENT_SET_BASE + set);
+        else
+            process_idle_wait();
+        s->waiting = 0;
+    }
+    s->timeout_remaining = -1;
+    irq_restore(flags);
+    return n;
+}
+
+/* -------------------------------------------------- */
+/* Kernel hooks                                       */
+/* -------------------------------------------------- */
+
+/* Called by process_wakeup_event(): wake sets that contain 'event_id' */
+void event_wakeup_sets(int event_id) {
+    if (event_id >= EVENT_SET_BASE)
+        return;
+
+    for (int i = 0; i < EVENT_MAX_SETS; i++) {
+        if (!sets[i].in_use || !sets[i].waiting)
+            continue;
+        for (int j = 0; j < sets[i].count; j++) {
+            if (sets[i].event_ids[j] == event_id) {
+                process_wakeup_event(EVENT_SET_BASE + i);
+                break;
+            }
+        }
+    }
+}
+
+/* Called from the PIT interrupt: advance timers and set timeouts */
+void event_timer_tick(void) {
+    for (int i = 0; i < EVENT_MAX_OBJECTS; i++) {
+        event_object_t *obj = &objects[i];
+        if (obj->type == EVOBJ_TIMER && --obj->remaining == 0) {
+            obj->remaining = obj->period;
+            obj->count++;
+            process_wakeup_event(obj->event_id);
+        }
+    }
+
+    for (int i = 0; i < EVENT_MAX_SETS; i++) {
+        if (sets[i].in_use && sets[i].timeout_remaining > 0 &&
+            --sets[i].timeout_remaining == 0) {
+            sets[i].timed_out = 1;
+            process_wakeup_event(EVENT_SET_BASE + i);
+        }
+    }
+}
@@ -0,0 +1,42 @@
+/* event.h - Waiting on several event sources at once */
+#ifndef EVENT_H
+#define EVENT_H
+
+#include "types.h"
+
+#define EVENT_MAX_OBJECTS   32   /* Registered sources, counters and timers */
+#define EVENT_MAX_SETS      8
+#define EVENT_SET_SIZE      16   /* Sources per set */
+
+#define EVENT_WAIT_FOREVER  -1
+
+/* One entry of the batch filled in by event_set_wait() */
+typedef struct {
+    int event_id;           /* Source that is ready */
+    uint32_t data;          /* Cookie passed to event_set_add() */
+} event_ready_t;
+
+typedef int (*event_ready_fn)(int arg);
+
+/* Sources: drivers advertise readiness for their existing event IDs */
+int event_register_source(int event_id, event_ready_fn ready, int arg);
+
+/* Counters (eventfd-like) and periodic timers (timerfd-like) */
+int event_counter_create(void);
+void event_counter_signal(int event_id);
+int event_timer_create(uint32_t period_ticks);
+uint32_t event_take(int event_id);
+void event_close(int event_id);
+
+/* Interest sets (epoll-like) */
+int event_set_create(void);
+void event_set_destroy(int set);
+int event_set_add(int set, int event_id, uint32_t data);
+int event_set_remove(int set, int event_id);
+int event_set_wait(int set, event_ready_t *ready, int max_ready, int timeout_ticks);
+
+/* Hooks for the rest of the kernel */
+void event_timer_tick(void);
+void event_wakeup_sets(int event_id);
+
+#endif
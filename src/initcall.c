@@ -0,0 +1,158 @@
+/* initcall.c - Ordered, timed subsystem initialisation */
+#include "initcall.h"
+#include "boottime.h"
+#include "timer.h"
+#include "kprintf.h"
+#include "klog.h"
+#include "cpu.h"
+#include "shell.h"
+
+/* Bounds of the pointer table, from link.ld */
+extern const initcall_t *const __initcall_start[];
+extern const initcall_t *const __initcall_end[];
+
+#define IC_PENDING  0
+#define IC_DONE     1
+#define IC_FAILED   2
+#define IC_SKIPPED  3
+
+typedef struct {
+    int status;
+    int wave;               /* Dependency depth within the level */
+    uint64_t cycles;
+} initcall_state_t;
+
+static initcall_state_t state[INITCALL_MAX];
+static int count;
+
+static int find_initcall(const char *name, size_t len) {
+    for (int i = 0; i < count; i++) {
+        const char *n = __initcall_start[i]->name;
+        size_t k = 0;
+        while (k < len && n[k] == name[k])
+            k++;
+        if (k == len && n[k] == '\0')
+            return i;
+    }
+    return -1;
+}
+
+/*
+ * 1 if everything in 'after' has run, 0 if something is still pending,
+ * -1 if a dependency is unknown, failed, or sits at a later level.
+ */
+static int deps_ready(int i) {
+    const char *p = __initcall_start[i]->after;
+    int ready = 1;
+
+    while (p && *p) {
+        while (*p == ' ')
+            p++;
+        const char *name = p;
+        while (*p && *p != ' ')
+            p++;
+        if (p == name)
+            break;
+
+        int j = find_initcall(name, p - name);
+        if (j < 0 || __initcall_start[j]->level > __initcall_start[i]->level ||
+            state[j].status == IC_FAILED || state[j].status == IC_SKIPPED)
+            return -1;
+        if (state[j].status == IC_PENDING)
+            ready = 0;
+    }
+    return ready;
+}
+
+static void run_initcall(int i, int wave) {
+    const initcall_t *call = __initcall_start[i];
+
+    uint64_t start = rdtsc();
+    int result = call->fn();
+    state[i].cycles = rdtsc() - start;
+    state[i].wave = wave;
+    state[i].status = result == 0 ? IC_DONE : IC_FAILED;
+    boottime_mark(call->name);
+
+    if (result != 0)
+        klog(KLOG_ERR, "initcall %s failed (%d)", call->name, result);
+}
+
+/*
+ * Run every registered initcall, level by level. Within a level the calls
+ * go in waves: a wave is everything whose dependencies ran in earlier
+ * waves, so its members are independent of each other and could be spread
+ * over several CPUs; with one CPU they run back to back. Calls whose
+ * dependencies fail, are missing or form a cycle are skipped.
+ */
+void initcall_run_all(void) {
+    count = __initcall_end - __initcall_start;
+    if (count > INITCALL_MAX) {
+        klog(KLOG_ERR, "%d initcalls registered, running the first %d", count, INITCALL_MAX);
+        count = INITCALL_MAX;
+    }
+
+    for (uint32_t level = 0; level <= INIT_LEVEL_MAX; level++) {
+        for (int wave = 0;; wave++) {
+            int batch[INITCALL_MAX];
+            int n = 0, waiting = 0;
+
+            for (int i = 0; i < count; i++) {
+                if (__initcall_start[i]->level != level || state[i].status != IC_PENDING)
+                    continue;
+                int ready = deps_ready(i);
+                if (ready < 0) {
+                    state[i].status = IC_SKIPPED;
+                    klog(KLOG_ERR, "initcall %s skipped: dependency missing or failed",
+                         __initcall_start[i]->name);
+                } else if (ready) {
+                    batch[n++] = i;
+                } else {
+                    waiting++;
+                }
+            }
+
+            if (n == 0) {
+                /* Nothing runnable but calls still waiting: a cycle */
+                for (int i = 0; waiting && i < count; i++) {
+                    if (__initcall_start[i]->level == level && state[i].status == IC_PENDING) {
+                        state[i].status = IC_SKIPPED;
+                        klog(KLOG_ERR, "initcall %s skipped: dependency cycle",
+                             __initcall_start[i]->name);
+                    }
+                }
+                break;
+            }
+            for (int k = 0; k < n; k++)
+                run_initcall(batch[k], wave);
+        }
+    }
+}
+
+static const char *status_name(int status) {
+    switch (status) {
+        case IC_DONE:    return "ok";
+        case IC_FAILED:  return "FAILED";
+        case IC_SKIPPED: return "skipped";
+        default:         return "pending";
+    }
+}
+
+void initcall_report(void) {
+    kprintf("%-16s %5s %4s %-8s %10s %6s  %s\n",
+            "initcall", "level", "wave", "status", "cycles", "us", "after");
+    for (int i = 0; i < count; i++) {
+        const initcall_t *call = __initcall_start[i];
+        kprintf("%-16s %5u %4d %-8s %10llu %6u  %s\n", call->name, call->level,
+                state[i].wave, status_name(state[i].status), state[i].cycles,
+                timer_cycles_to_us(state[i].cycles), call->after ? call->after : "");
+    }
+}
+
+static int initcalls_command(int argc, char **argv) {
+    (void)argc;
+    (void)argv;
+    initcall_report();
+    return SHELL_OK;
+}
+SHELL_COMMAND("initcalls", initcalls_command, NULL, "Init order, dependencies and timing");
@@ -0,0 +1,40 @@
+/* initcall.h - Subsystem init functions collected in a linker section */
+#ifndef INITCALL_H
+#define INITCALL_H
+
+#include "types.h"
+
+/* Levels run in increasing order; each starts once the previous is done */
+#define INIT_LEVEL_CPU     0   /* CPU features, instruction set selection */
+#define INIT_LEVEL_IRQ     1   /* IDT and interrupt controller */
+#define INIT_LEVEL_DEVICE  2   /* Drivers and clocks */
+#define INIT_LEVEL_KERNEL  3   /* Heap, processes */
+#define INIT_LEVEL_MAX     INIT_LEVEL_KERNEL
+
+#define INITCALL_MAX       32
+
+typedef struct {
+    const char *name;
+    int (*fn)(void);        /* Returns 0 on success */
+    uint32_t level;
+    const char *after;      /* Space-separated names that must run first, or NULL */
+} initcall_t;
+
+#define INITCALL_STR1(x) #x
+#define INITCALL_STR(x)  INITCALL_STR1(x)
+
+/*
+ * Register fn to run at boot. The section holds pointers (not the
+ * descriptors themselves) so the table has no alignment padding; link.ld
+ * sorts the .initcall.<level> input sections by name.
+ */
+#define INITCALL(name, fn, level, after)                                     \
+    static const initcall_t initcall_desc_##fn = { name, fn, level, after }; \
+    static const initcall_t *const initcall_ptr_##fn                        \
+        __attribute__((section(".initcall." INITCALL_STR(level)), used))    \
+        = &initcall_desc_##fn
+
+void initcall_run_all(void);
+void initcall_report(void);
+
+#endif
@@ -0,0 +1,167 @@
+/* interrupt.c - IDT setup, 8259 PIC remapping and IRQ dispatch */
+#include "interrupt.h"
+#include "serial.h"
+#include "kprintf.h"
+#include "klog.h"
+#include "io.h"
+#include "process.h"
+#include "initcall.h"
+
+#define IDT_ENTRIES   48
+#define KERNEL_CS     0x08      /* Flat code segment loaded in boot.S */
+#define IDT_GATE_INT  0x8E      /* Present, ring 0, 32-bit interrupt gate */
+
+#define PIC1_CMD      0x20
+#define PIC1_DATA     0x21
+#define PIC2_CMD      0xA0
+#define PIC2_DATA     0xA1
+#define PIC_EOI       0x20
+
+typedef struct {
+    uint16_t offset_low;
+    uint16_t selector;
+    uint8_t  zero;
+    uint8_t  type_attr;
+    uint16_t offset_high;
+} __attribute__((packed)) idt_entry_t;
+
+typedef struct {
+    uint16_t limit;
+    uint32_t base;
+} __attribute__((packed)) idt_ptr_t;
+
+static idt_entry_t idt[IDT_ENTRIES];
+static irq_handler_t irq_handlers[IRQ_COUNT];
+
+extern uint32_t isr_stub_table[IDT_ENTRIES];
+
+static void idt_set_gate(int vector, uint32_t handler) {
+    idt[vector].offset_low = handler & 0xFFFF;
+    idt[vector].selector = KERNEL_CS;
+    idt[vector].zero = 0;
+    idt[vector].type_attr = IDT_GATE_INT;
+    idt[vector].offset_high = (handler >> 16) & 0xFFFF;
+}
+
+/* Remap the PICs so IRQ 0-15 do not collide with CPU exceptions */
+static void pic_remap(void) {
+    outb(PIC1_CMD, 0x11);           /* ICW1: init, expect ICW4 */
+    io_wait();
+    outb(PIC2_CMD, 0x11);
+    io_wait();
+    outb(PIC1_DATA, IRQ_BASE);      /* ICW2: master vector offset */
+    io_wait();
+    outb(PIC2_DATA, IRQ_BASE + 8);  /* ICW2: slave vector offset */
+    io_wait();
+    outb(PIC1_DATA, 0x04);          /* ICW3: slave on IRQ2 */
+    io_wait();
+    outb(PIC2_DATA, 0x02);          /* ICW3: slave cascade identity */
+    io_wait();
+    outb(PIC1_DATA, 0x01);          /* ICW4: 8086 mode */
+    io_wait();
+    outb(PIC2_DATA, 0x01);
+    io_wait();
+
+    /* Mask everything except the cascade line until drivers ask */
+    outb(PIC1_DATA, (uint8_t)~(1 << IRQ_CASCADE));
+    outb(PIC2_DATA, 0xFF);
+}
+
+void interrupt_initialize(void) {
+    idt_ptr_t idtr;
+
+    for (int i = 0; i < IDT_ENTRIES; i++) {
+        idt_set_gate(i, isr_stub_table[i]);
+    }
+    for (int i = 0; i < IRQ_COUNT; i++) {
+        irq_handlers[i] = NULL;
+    }
+
+    pic_remap();
+
+    idtr.limit = sizeof(idt) - 1;
+    idtr.base = (uint32_t)idt;
+    __asm__ volatile ("lidt %0" : : "m"(idtr));
+
+    klog(KLOG_INFO, "Interrupts initialized");
+}
+
+static int interrupt_init(void) {
+    interrupt_initialize();
+    return 0;
+}
+INITCALL("interrupt", interrupt_init, INIT_LEVEL_IRQ, NULL);
+
+void irq_install_handler(int irq, irq_handler_t handler) {
+    if (irq < 0 || irq >= IRQ_COUNT) return;
+    irq_handlers[irq] = handler;
+}
+
+void irq_enable(int irq) {
+    if (irq < 8) {
+        outb(PIC1_DATA, inb(PIC1_DATA) & ~(1 << irq));
+    } else {
+        outb(PIC2_DATA, inb(PIC2_DATA) & ~(1 << (irq - 8)));
+    }
+}
+
+void irq_disable_line(int irq) {
+    if (irq < 8) {
+        outb(PIC1_DATA, inb(PIC1_DATA) | (1 << irq));
+    } else {
+        outb(PIC2_DATA, inb(PIC2_DATA) | (1 << (irq - 8)));
+    }
+}
+
+/* A spurious IRQ 7/15 has no bit set in the PIC's in-service register */
+static int irq_is_spurious(int irq) {
+    if (irq == 7) {
+        outb(PIC1_CMD, 0x0B);
+        return !(inb(PIC1_CMD) & 0x80);
+    }
+    if (irq == 15) {
+        outb(PIC2_CMD, 0x0B);
+        if (!(inb(PIC2_CMD) & 0x80)) {
+            outb(PIC1_CMD, PIC_EOI);    /* Master still saw the cascade */
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void exception_panic(interrupt_frame_t *frame) {
+    klog_sync();
+    kprintf("\n*** CPU exception %u (error 0x%08X) at EIP 0x%08X ***\n"
+            "System halted.\n", frame->vector, frame->error_code, frame->eip);
+    serial_flush();
+    for (;;) {
+        __asm__ volatile ("cli; hlt");
+    }
+}
+
+/* Called from interrupt_common in isr.S with interrupts disabled */
+void interrupt_dispatch(interrupt_frame_t *frame) {
+    if (frame->vector < IRQ_BASE) {
+        exception_panic(frame);
+        return;
+    }
+
+    int irq = frame->vector - IRQ_BASE;
+    if (irq_is_spurious(irq))
+        return;
+
+    /*
+     * Acknowledge before running the handler: handlers drain their device
+     * until it deasserts the line, and a handler may switch to another
+     * process, which must not leave the PIC waiting for an EOI.
+     */
+    if (irq >= 8)
+        outb(PIC2_CMD, PIC_EOI);
+    outb(PIC1_CMD, PIC_EOI);
+
+    if (irq_handlers[irq])
+        irq_handlers[irq](frame);
+
+    /* A wakeup or an expired time slice may switch processes here */
+    process_preempt();
+}
@@ -0,0 +1,70 @@
+/* interrupt.h - IDT, PIC and IRQ dispatch interface */
+#ifndef INTERRUPT_H
+#define INTERRUPT_H
+
+#include "types.h"
+
+/* Hardware IRQ lines are remapped to vectors 32-47 */
+#define IRQ_BASE      32
+#define IRQ_COUNT     16
+
+#define IRQ_TIMER     0
+#define IRQ_KEYBOARD  1
+#define IRQ_CASCADE   2
+#define IRQ_COM2      3
+#define IRQ_COM1      4
+#define IRQ_RTC       8
+
+#define EFLAGS_IF     0x200
+
+/* Register state pushed by the stubs in isr.S (lowest address first) */
+typedef struct {
+    uint32_t edi, esi, ebp, esp, ebx, edx, ecx, eax;   /* pushal */
+    uint32_t vector;                                   /* Interrupt vector */
+    uint32_t error_code;                               /* CPU error code or 0 */
+    uint32_t eip, cs, eflags;                          /* Pushed by the CPU */
+} interrupt_frame_t;
+
+typedef void (*irq_handler_t)(interrupt_frame_t *frame);
+
+void interrupt_initialize(void);
+void irq_install_handler(int irq, irq_handler_t handler);
+void irq_enable(int irq);
+void irq_disable_line(int irq);
+
+/* Disable interrupts, returning the previous EFLAGS for irq_restore() */
+static inline uint32_t irq_save(void) {
+    uint32_t flags;
+    __asm__ volatile ("pushfl; popl %0; cli" : "=r"(flags) : : "memory");
+    return flags;
+}
+
+static inline void irq_restore(uint32_t flags) {
+    if (flags & EFLAGS_IF)
+        __asm__ volatile ("sti" : : : "memory");
+}
+
+static inline int irq_enabled(void) {
+    uint32_t flags;
+    __asm__ volatile ("pushfl; popl %0" : "=r"(flags));
+    return (flags & EFLAGS_IF) != 0;
+}
+
+static inline void interrupts_enable(void) {
+    __asm__ volatile ("sti" : : : "memory");
+}
+
+static inline void interrupts_disable(void) {
+    __asm__ volatile ("cli" : : : "memory");
+}
+
+/*
+ * Halt until the next interrupt. "sti; hlt" is atomic (sti only takes
+ * effect after the following instruction), so a caller that checked a
+ * condition with interrupts disabled cannot miss the wakeup.
+ */
+static inline void cpu_idle(void) {
+    __asm__ volatile ("sti; hlt" : : : "memory");
+}
+
+#endif
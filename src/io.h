@@ -14,4 +14,9 @@ static inline uint8_t inb(uint16_t port) {
     return ret;
 }
 
+/* Short delay for slow devices such as the 8259 PIC */
+static inline void io_wait(void) {
+    outb(0x80, 0);
+}
+
 #endif
\ No newline at end of file
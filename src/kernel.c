@@ -4,8 +4,24 @@
 #include "string.h"
 #include "memory.h"
 #include "process.h"
+#include "interrupt.h"
+#include "timer.h"
+#include "cpu.h"
+#include "kprintf.h"
+#include "klog.h"
+#include "vga.h"
+#include "keyboard.h"
+#include "console.h"
+#include "event.h"
+#include "bench.h"
+#include "cmdline.h"
+#include "boottime.h"
+#include "initcall.h"
+#include "shell.h"
 
-#define MAX_INPUT 128
+#define KLOGD_HZ 10        /* Kernel log flushes per second */
+#define STRING_TEST_MAX    160      /* Sizes 0..N-1 at every alignment */
+#define STRING_TEST_ALIGN  16
 
 /* External reference to process table */
 extern pcb_t proctab[];
@@ -14,9 +30,7 @@ extern pcb_t proctab[];
 void process_a(void) {
     serial_puts("[Process A] Starting...\n");
     for (int i = 0; i < 3; i++) {
-        serial_puts("[Process A] Running iteration ");
-        serial_put_uint(i + 1);
-        serial_puts("\n");
+        kprintf("[Process A] Running iteration %d\n", i + 1);
         
         /* Simulate some work */
         for (volatile int j = 0; j < 1000000; j++);
@@ -27,9 +41,7 @@ void process_a(void) {
 void process_b(void) {
     serial_puts("[Process B] Starting...\n");
     for (int i = 0; i < 3; i++) {
-        serial_puts("[Process B] Running iteration ");
-        serial_put_uint(i + 1);
-        serial_puts("\n");
+        kprintf("[Process B] Running iteration %d\n", i + 1);
         
         /* Simulate some work */
         for (volatile int j = 0; j < 1000000; j++);
@@ -40,9 +52,7 @@ void process_b(void) {
 void process_c(void) {
     serial_puts("[Process C] Starting (Low Priority)...\n");
     for (int i = 0; i < 2; i++) {
-        serial_puts("[Process C] Running iteration ");
-        serial_put_uint(i + 1);
-        serial_puts("\n");
+        kprintf("[Process C] Running iteration %d\n", i + 1);
         
         /* Simulate some work */
         for (volatile int j = 0; j < 1000000; j++);
@@ -56,19 +66,13 @@ void test_memory(void) {
     
     /* Test heap allocation */
     void *memory_block_1 = memory_allocate(100);
-    serial_puts("Allocated 100 bytes at ");
-    serial_put_hex((uint32_t)memory_block_1);
-    serial_puts("\n");
+    kprintf("Allocated 100 bytes at %p\n", memory_block_1);
     
     void *memory_block_2 = memory_allocate(200);
-    serial_puts("Allocated 200 bytes at ");
-    serial_put_hex((uint32_t)memory_block_2);
-    serial_puts("\n");
+    kprintf("Allocated 200 bytes at %p\n", memory_block_2);
     
     void *memory_block_3 = memory_allocate(50);
-    serial_puts("Allocated 50 bytes at ");
-    serial_put_hex((uint32_t)memory_block_3);
-    serial_puts("\n");
+    kprintf("Allocated 50 bytes at %p\n", memory_block_3);
     
     /* Free some memory */
     memory_deallocate(memory_block_2);
@@ -76,9 +80,179 @@ void test_memory(void) {
     
     /* Allocate again (should reuse freed space) */
     void *memory_block_4 = memory_allocate(150);
-    serial_puts("Allocated 150 bytes at ");
-    serial_put_hex((uint32_t)memory_block_4);
-    serial_puts("\n");
+    kprintf("Allocated 150 bytes at %p\n", memory_block_4);
+}
+
+/* Wait on serial input, the keyboard and a 1 s timer through one event set */
+void event_demo(void) {
+    event_ready_t ready[4];
+    int set = event_set_create();
+    int timer = event_timer_create(timer_hz());
+
+    if (set < 0 || timer < 0) {
+        serial_puts("No free event sets or timers\n");
+        event_close(timer);
+        event_set_destroy(set);
+        return;
+    }
+    event_set_add(set, EVENT_SERIAL_RX + SERIAL_CONSOLE, 0);
+    event_set_add(set, EVENT_KEYBOARD, 1);
+    event_set_add(set, timer, 2);
+
+    serial_puts("Waiting on serial, keyboard and a 1s timer ('q' stops, 10s timeout)\n");
+    for (int done = 0; !done; ) {
+        int n = event_set_wait(set, ready, 4, 10 * timer_hz());
+        if (n == 0) {
+            serial_puts("timeout\n");
+            break;
+        }
+        for (int i = 0; i < n; i++) {
+            int c;
+            switch (ready[i].data) {
+                case 0:
+                case 1:
+                    c = ready[i].data == 0 ? serial_port_try_getc(SERIAL_CONSOLE)
+                                           : keyboard_try_getc();
+                    if (c < 0)
+                        break;
+                    kprintf("%s: '%c'\n", ready[i].data == 0 ? "serial" : "keyboard", c);
+                    if (c == 'q')
+                        done = 1;
+                    break;
+                case 2:
+                    kprintf("timer: %u expiration(s) at tick %u\n",
+                            event_take(timer), timer_ticks());
+                    break;
+            }
+        }
+    }
+
+    event_close(timer);
+    event_set_destroy(set);
+}
+
+/* Byte-at-a-time references; kept as loops rather than turned into calls */
+__attribute__((noinline, optimize("no-tree-loop-distribute-patterns")))
+static void byte_set(uint8_t *p, uint8_t value, size_t n) {
+    while (n--)
+        *p++ = value;
+}
+
+__attribute__((noinline, optimize("no-tree-loop-distribute-patterns")))
+static void byte_copy(uint8_t *d, const uint8_t *s, size_t n) {
+    while (n--)
+        *d++ = *s++;
+}
+
+static void fill_pattern(uint8_t *p, size_t n, uint32_t seed) {
+    for (size_t i = 0; i < n; i++) {
+        p[i] = (uint8_t)(seed + i * 7);
+    }
+}
+
+static int bytes_equal(const uint8_t *a, const uint8_t *b, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        if (a[i] != b[i])
+            return 0;
+    }
+    return 1;
+}
+
+/* Check memset/memcpy/memmove/memcmp against byte loops at every size/alignment */
+void test_string(void) {
+    uint8_t *src = memory_allocate(STRING_TEST_MAX * 2 + STRING_TEST_ALIGN);
+    uint8_t *dst = memory_allocate(STRING_TEST_MAX * 2 + STRING_TEST_ALIGN);
+    uint8_t *ref = memory_allocate(STRING_TEST_MAX * 2 + STRING_TEST_ALIGN);
+    uint32_t checks = 0, failures = 0;
+
+    if (!src || !dst || !ref) {
+        serial_puts("test_string: allocation failed\n");
+        goto out;
+    }
+
+    for (size_t n = 0; n < STRING_TEST_MAX; n++) {
+        for (int sa = 0; sa < STRING_TEST_ALIGN; sa++) {
+            for (int da = 0; da < STRING_TEST_ALIGN; da++) {
+                fill_pattern(src, STRING_TEST_MAX + STRING_TEST_ALIGN, n);
+                fill_pattern(dst, STRING_TEST_MAX + STRING_TEST_ALIGN, n + 99);
+                byte_copy(ref, dst, STRING_TEST_MAX + STRING_TEST_ALIGN);
+
+                memcpy(dst + da, src + sa, n);
+                byte_copy(ref + da, src + sa, n);
+                failures += !bytes_equal(dst, ref, STRING_TEST_MAX + STRING_TEST_ALIGN);
+
+                memset(dst + da, 0x5A, n);
+                byte_set(ref + da, 0x5A, n);
+                failures += !bytes_equal(dst, ref, STRING_TEST_MAX + STRING_TEST_ALIGN);
+
+                /* memcmp: equal, then a difference in the last byte */
+                byte_copy(dst, src, STRING_TEST_MAX + STRING_TEST_ALIGN);
+                failures += memcmp(dst + da, src + da, n) != 0;
+                if (n > 0) {
+                    dst[da + n - 1] ^= 0x80;
+                    int r = memcmp(dst + da, src + da, n);
+                    failures += (dst[da + n - 1] < src[da + n - 1]) ? r >= 0 : r <= 0;
+                }
+
+                /* strlen: n non-zero bytes then a terminator */
+                byte_set(dst + da, 'x', n);
+                dst[da + n] = '\0';
+                failures += strlen((const char *)dst + da) != n;
+                checks += 5;
+            }
+        }
+
+        /* memmove with overlap in both directions */
+        for (int shift = -5; shift <= 5; shift++) {
+            uint8_t *base = src + 8;
+            fill_pattern(src, STRING_TEST_MAX * 2 + 8, n);
+            byte_copy(ref, src, STRING_TEST_MAX * 2 + 8);
+            /* Reference: bounce through dst so overlap cannot matter */
+            byte_copy(dst, ref + 8, n);
+            byte_copy(ref + 8 + shift, dst, n);
+
+            memmove(base + shift, base, n);
+            failures += !bytes_equal(src, ref, STRING_TEST_MAX * 2 + 8);
+            checks++;
+        }
+
+        /* strnlen/strcmp/strncmp/memchr/strncpy on n-character strings */
+        for (int sa = 0; sa < 4; sa++) {
+            for (int da = 0; da < 4; da++) {
+                char *s1 = (char *)src + sa;
+                char *s2 = (char *)dst + da;
+                byte_set(src, 'a', n + 8);
+                byte_set(dst, 'a', n + 8);
+                s1[n] = s2[n] = '\0';
+
+                failures += strnlen(s1, n + 4) != n;
+                failures += n > 0 && strnlen(s1, n - 1) != n - 1;
+                failures += strcmp(s1, s2) != 0 || strncmp(s1, s2, n + 4) != 0;
+                failures += memchr(s1, '\0', n + 1) != s1 + n;
+                if (n > 0) {
+                    s2[n - 1] = 'b';
+                    failures += strcmp(s1, s2) >= 0 || strncmp(s1, s2, n) >= 0;
+                    failures += strncmp(s1, s2, n - 1) != 0;
+                    failures += memchr(s2, 'b', n) != s2 + n - 1;
+                }
+
+                /* strncpy copies n bytes, pads 4 zeros, leaves the rest */
+                byte_set(ref, 0x77, n + 12);
+                strncpy((char *)ref + da, s1, n + 4);
+                failures += !bytes_equal(ref + da, (uint8_t *)s1, n + 1) ||
+                            ref[da + n + 3] != 0 || ref[da + n + 4] != 0x77;
+                checks += 8;
+            }
+        }
+    }
+
+    kprintf("string tests: %u checks, %u failures%s%s\n", checks, failures,
+            string_sse2_active() ? " (SSE2)" : "",
+            cpu_has(CPU_FEATURE_ERMSB) ? " (ERMSB)" : "");
+out:
+    memory_deallocate(ref);
+    memory_deallocate(dst);
+    memory_deallocate(src);
 }
 
 /* Demo the OS features - XINU Style */
@@ -93,34 +267,131 @@ void demo_os(void) {
     serial_puts("Type 'run' to execute processes.\n");
 }
 
-void kmain(void) {
-    char user_input[MAX_INPUT];
+/* -------------------------------------------------- */
+/* Shell commands                                     */
+/* -------------------------------------------------- */
+
+static int demo_command(int argc, char **argv) {
+    (void)argc;
+    (void)argv;
+    demo_os();
+    return SHELL_OK;
+}
+SHELL_COMMAND("demo", demo_command, NULL, "Create demo processes");
+
+/* Processes run as soon as they are created; this waits for them */
+static int run_command(int argc, char **argv) {
+    (void)argc;
+    (void)argv;
+    serial_puts("Waiting for processes...\n");
+    process_wait_all();
+    serial_puts("=== All Processes Completed! ===\n");
+    return SHELL_OK;
+}
+SHELL_COMMAND("run", run_command, NULL, "Wait for running processes to finish");
+
+/* Creates the three sample processes when no others are running */
+static int ps_command(int argc, char **argv) {
+    int has_processes = 0;
+
+    (void)argc;
+    (void)argv;
+    for (int i = 0; i < process_max(); i++) {
+        if (proctab[i].state != PR_TERMINATED && !(proctab[i].flags & PROC_F_KERNEL)) {
+            has_processes = 1;
+            break;
+        }
+    }
+
+    if (!has_processes) {
+        serial_puts("\n=== Creating Processes ===\n");
+        process_create(process_a);
+        process_create(process_b);
+        process_create(process_c);
+        serial_puts("\n");
+    }
+
+    process_list_display();
+    return SHELL_OK;
+}
+SHELL_COMMAND("ps", ps_command, NULL, "Show process list");
+
+static int evtest_command(int argc, char **argv) {
+    (void)argc;
+    (void)argv;
+    event_demo();
+    return SHELL_OK;
+}
+SHELL_COMMAND("evtest", evtest_command, NULL, "Wait on serial, keyboard and a timer at once");
+
+static int strtest_command(int argc, char **argv) {
+    (void)argc;
+    (void)argv;
+    test_string();
+    return SHELL_OK;
+}
+SHELL_COMMAND("strtest", strtest_command, NULL, "Check mem*/str* routines");
+
+static int clear_command(int argc, char **argv) {
+    (void)argc;
+    (void)argv;
+    for (int i = 0; i < 50; i++) {
+        serial_puts("\n");
+    }
+    vga_clear();
+    return SHELL_OK;
+}
+SHELL_COMMAND("clear", clear_command, NULL, "Clear screen");
+
+static int about_command(int argc, char **argv) {
+    (void)argc;
+    (void)argv;
+    serial_puts("\nkacchiOS - Educational Bare-metal OS\n");
+    serial_puts("Version: 3.0\n");
+    serial_puts("Features:\n");
+    serial_puts("  - Memory Manager (Heap allocation)\n");
+    serial_puts("  - Process Manager \n");
+    serial_puts("  - Scheduler (Priority + Aging)\n");
+    serial_puts("  - Context Switching\n");
+    serial_puts("  - Sleep/Wait/Wakeup\n");
+    return SHELL_OK;
+}
+SHELL_COMMAND("about", about_command, NULL, "About kacchiOS");
+
+/*
+ * The heap takes the first page after the kernel image, sized by heap=
+ * and clamped to the memory the loader reported above 1 MB
+ */
+static int heap_initialize(void) {
+    extern char __kernel_end[];
+    uint32_t base = (uint32_t)__kernel_end;
+    uint32_t size = boot_config.heap_size;
+
+    if (boot_config.mem_upper_kb) {
+        uint32_t avail_kb = 1024 + boot_config.mem_upper_kb - base / 1024;
+        if (size / 1024 > avail_kb) {
+            size = avail_kb * 1024;
+            klog(KLOG_WARN, "heap= exceeds memory, using %u KB", avail_kb);
+        }
+    }
+    memory_manager_initialize((void *)base, size);
+    return 0;
+}
+INITCALL("memory", heap_initialize, INIT_LEVEL_KERNEL, NULL);
+
+/* The interactive shell: reads a line, runs it, repeats */
+static void shell_process(void) {
+    char user_input[SHELL_LINE_MAX];
     int input_position = 0;
     
-    /* Initialize hardware */
-    serial_init();
-    
-    /* Print welcome message */
-    serial_puts("\n");
-    serial_puts("========================================\n");
-    serial_puts("              KacchiOS_X                \n");
-    serial_puts("========================================\n");
-    serial_puts("         Hello from kacchiOS!           \n");
-    
-    /* Initialize OS components */
-    serial_puts("Initializing OS components...\n");
-    memory_manager_initialize();
-    process_manager_initialize();
-    serial_puts("All components initialized successfully!\n");
-    
     /* Main loop - interactive shell */
     while (1) {
         serial_puts("\nX_Kacchi> ");
         input_position = 0;
         
-        /* Read input line */
+        /* Read input line; blocks this process, not the machine */
         while (1) {
-            char input_char = serial_getc();
+            char input_char = console_getc();
             
             /* Handle Enter key */
             if (input_char == '\r' || input_char == '\n') {
@@ -134,80 +405,68 @@ void kmain(void) {
                 serial_puts("\b \b");  /* Erase character on screen */
             }
             /* Handle normal characters */
-            else if (input_char >= 32 && input_char < 127 && input_position < MAX_INPUT - 1) {
+            else if (input_char >= 32 && input_char < 127 && input_position < SHELL_LINE_MAX - 1) {
                 user_input[input_position++] = input_char;
                 serial_putc(input_char);  /* Echo character */
             }
         }
         
-        /* Process commands */
-        if (input_position > 0) {
-            if (strcmp(user_input, "help") == 0) {
-                serial_puts("Available commands:\n");
-                serial_puts("  help     - Show this help message\n");
-                serial_puts("  demo     - Create demo processes\n");
-                serial_puts("  run      - Start process scheduling\n");
-                serial_puts("  mem      - Show memory statistics\n");
-                serial_puts("  ps       - Show process list\n");
-                serial_puts("  clear    - Clear screen\n");
-                serial_puts("  about    - About kacchiOS\n");
-            }
-            else if (strcmp(user_input, "demo") == 0) {
-                demo_os();
-            }
-            else if (strcmp(user_input, "run") == 0) {
-                serial_puts("Starting processes...\n");
-                process_scheduler_start();
-                /* Scheduler returns after running all processes */
-            }
-            else if (strcmp(user_input, "mem") == 0) {
-                serial_puts("Memory manager active (64KB heap)\n");
-            }
-            else if (strcmp(user_input, "ps") == 0) {
-                /* Check if processes exist, if not create them */
-                int has_processes = 0;
-                for (int i = 0; i < 16; i++) {  /* MAX_PROCS */
-                    if (proctab[i].state != PR_TERMINATED) {
-                        has_processes = 1;
-                        break;
-                    }
-                }
-                
-                if (!has_processes) {
-                    serial_puts("\n=== Creating Processes ===\n");
-                    process_create(process_a);
-                    process_create(process_b);
-                    process_create(process_c);
-                    serial_puts("\n");
-                }
-                
-                process_list_display();
-            }
-            else if (strcmp(user_input, "clear") == 0) {
-                for (int i = 0; i < 50; i++) {
-                    serial_puts("\n");
-                }
-            }
-            else if (strcmp(user_input, "about") == 0) {
-                serial_puts("\nkacchiOS - Educational Bare-metal OS\n");
-                serial_puts("Version: 3.0\n");
-                serial_puts("Features:\n");
-                serial_puts("  - Memory Manager (Heap allocation)\n");
-                serial_puts("  - Process Manager \n");
-                serial_puts("  - Scheduler (Priority + Aging)\n");
-                serial_puts("  - Context Switching\n");
-                serial_puts("  - Sleep/Wait/Wakeup\n");
-            }
-            else {
-                serial_puts("Unknown command: ");
-                serial_puts(user_input);
-                serial_puts("\nType 'help' for available commands.\n");
-            }
-        }
+        /* Dispatch through the SHELL_COMMAND() registry */
+        shell_execute(user_input);
     }
-    
-    /* Should never reach here */
+}
+
+/*
+ * Drain the kernel log a few times a second, so messages reach the
+ * console even when busy processes leave the null process no idle time
+ */
+static void klogd_process(void) {
+    uint32_t ticks = timer_hz() / KLOGD_HZ;
+
     for (;;) {
-        __asm__ volatile ("hlt");
+        klog_flush();
+        process_sleep(ticks ? ticks : 1);
     }
-}
\ No newline at end of file
+}
+
+static const process_attr_t shell_attr = { "shell", PRIO_SHELL, SHELL_STACK_SIZE, PROC_F_KERNEL };
+static const process_attr_t klogd_attr = { "klogd", PRIO_DEFAULT, 0, PROC_F_KERNEL };
+
+void kmain(uint32_t magic, const multiboot_info_t *mbi) {
+    /* Initialize hardware; boottime_mark() closes each timed phase */
+    serial_init();
+    boottime_mark("serial_init");
+    klog_initialize();
+    cmdline_initialize(magic, mbi);
+    boottime_mark("cmdline");
+    vga_initialize();
+    serial_set_console_mirror(vga_write);
+    boottime_mark("vga_initialize");
+    
+    /* Print welcome message */
+    serial_puts("\n");
+    serial_puts("========================================\n");
+    serial_puts("              KacchiOS_X                \n");
+    serial_puts("========================================\n");
+    serial_puts("         Hello from kacchiOS!           \n");
+    
+    /* Initialize OS components */
+    serial_puts("Initializing OS components...\n");
+    boottime_mark("banner");
+    initcall_run_all();     /* Subsystems registered with INITCALL() */
+    interrupts_enable();
+    klog(KLOG_INFO, "All components initialized successfully!");
+    klog_sync();
+    boottime_mark("console_drain");
+
+    /* Headless benchmark boot (make bench-qemu): measure, report, exit */
+    if (boot_config.bench)
+        qemu_exit(bench_run_headless());
+    
+    /* The shell and klogd run as processes; kmain becomes the null process */
+    if (process_spawn(&shell_attr, shell_process, NULL) < 0)
+        klog(KLOG_ERR, "Cannot start the shell process");
+    if (process_spawn(&klogd_attr, klogd_process, NULL) < 0)
+        klog(KLOG_WARN, "Cannot start klogd; the log drains only when idle");
+    process_null_loop();
+}
@@ -0,0 +1,168 @@
+/* keyboard.c - PS/2 keyboard driver (IRQ 1, scancode set 1) */
+#include "keyboard.h"
+#include "interrupt.h"
+#include "process.h"
+#include "event.h"
+#include "klog.h"
+#include "io.h"
+#include "initcall.h"
+
+#define KBD_DATA      0x60
+#define KBD_STATUS    0x64
+#define KBD_OUTPUT_FULL 0x01
+
+#define SC_RELEASE    0x80
+#define SC_EXTENDED   0xE0
+#define SC_LCTRL      0x1D
+#define SC_LSHIFT     0x2A
+#define SC_RSHIFT     0x36
+#define SC_CAPSLOCK   0x3A
+
+/* Set 1 make codes to ASCII, unshifted and shifted (0 = no character) */
+static const char keymap[128] = {
+    0,    27,  '1', '2', '3', '4', '5', '6', '7', '8', '9', '0', '-', '=', '\b',
+    '\t', 'q', 'w', 'e', 'r', 't', 'y', 'u', 'i', 'o', 'p', '[', ']', '\n',
+    0,    'a', 's', 'd', 'f', 'g', 'h', 'j', 'k', 'l', ';', '\'', '`',
+    0,    '\\', 'z', 'x', 'c', 'v', 'b', 'n', 'm', ',', '.', '/', 0,
+    '*',  0,   ' '
+};
+
+static const char keymap_shift[128] = {
+    0,    27,  '!', '@', '#', '$', '%', '^', '&', '*', '(', ')', '_', '+', '\b',
+    '\t', 'Q', 'W', 'E', 'R', 'T', 'Y', 'U', 'I', 'O', 'P', '{', '}', '\n',
+    0,    'A', 'S', 'D', 'F', 'G', 'H', 'J', 'K', 'L', ':', '"', '~',
+    0,    '|', 'Z', 'X', 'C', 'V', 'B', 'N', 'M', '<', '>', '?', 0,
+    '*',  0,   ' '
+};
+
+/*
+ * Single-producer (the IRQ handler advances head) / single-consumer
+ * (readers advance tail) ring: neither side needs a lock.
+ */
+static volatile char kbd_buffer[KEYBOARD_BUFFER_SIZE];
+static volatile uint32_t kbd_head = 0;
+static volatile uint32_t kbd_tail = 0;
+static volatile uint32_t kbd_dropped = 0;
+
+static int shift_down = 0;
+static int ctrl_down = 0;
+static int caps_lock = 0;
+static int extended = 0;
+
+static char keyboard_translate(uint8_t scancode) {
+    int released = scancode & SC_RELEASE;
+    uint8_t code = scancode & ~SC_RELEASE;
+
+    if (extended) {
+        /* E0-prefixed keys: right Ctrl counts, the rest are ignored */
+        extended = 0;
+        if (code == SC_LCTRL)
+            ctrl_down = !released;
+        return 0;
+    }
+
+    switch (code) {
+        case SC_LSHIFT:
+        case SC_RSHIFT:
+            shift_down = !released;
+            return 0;
+        case SC_LCTRL:
+            ctrl_down = !released;
+            return 0;
+        case SC_CAPSLOCK:
+            if (!released)
+                caps_lock = !caps_lock;
+            return 0;
+    }
+    if (released)
+        return 0;
+
+    char c = shift_down ? keymap_shift[code] : keymap[code];
+    if (caps_lock && c >= 'a' && c <= 'z')
+        c -= 'a' - 'A';
+    else if (caps_lock && c >= 'A' && c <= 'Z')
+        c += 'a' - 'A';
+    if (ctrl_down && c >= 'a' && c <= 'z')
+        c = c - 'a' + 1;
+    else if (ctrl_down && c >= 'A' && c <= 'Z')
+        c = c - 'A' + 1;
+    return c;
+}
+
+static void keyboard_irq_handler(interrupt_frame_t *frame) {
+    (void)frame;
+    int received = 0;
+
+    while (inb(KBD_STATUS) & KBD_OUTPUT_FULL) {
+        uint8_t scancode = inb(KBD_DATA);
+        if (scancode == SC_EXTENDED) {
+            extended = 1;
+            continue;
+        }
+
+        char c = keyboard_translate(scancode);
+        if (!c)
+            continue;
+        if (kbd_head - kbd_tail < KEYBOARD_BUFFER_SIZE) {
+            kbd_buffer[kbd_head % KEYBOARD_BUFFER_SIZE] = c;
+            kbd_head++;
+            received = 1;
+        } else {
+            kbd_dropped++;
+        }
+    }
+
+    if (received) {
+        process_wakeup_event(EVENT_KEYBOARD);
+        process_wakeup_event(EVENT_CONSOLE_INPUT);
+    }
+}
+
+void keyboard_initialize(void) {
+    /* Discard anything the firmware left in the controller */
+    while (inb(KBD_STATUS) & KBD_OUTPUT_FULL)
+        inb(KBD_DATA);
+
+    irq_install_handler(IRQ_KEYBOARD, keyboard_irq_handler);
+    irq_enable(IRQ_KEYBOARD);
+    event_register_source(EVENT_KEYBOARD, keyboard_available, 0);
+    klog(KLOG_INFO, "PS/2 keyboard initialized");
+}
+
+static int keyboard_init(void) {
+    keyboard_initialize();
+    return 0;
+}
+INITCALL("keyboard", keyboard_init, INIT_LEVEL_DEVICE, "interrupt");
+
+/* Event source readiness */
+int keyboard_available(int arg) {
+    (void)arg;
+    return kbd_tail != kbd_head;
+}
+
+/* Next character, or -1 if none is buffered */
+int keyboard_try_getc(void) {
+    if (kbd_tail == kbd_head)
+        return -1;
+    char c = kbd_buffer[kbd_tail % KEYBOARD_BUFFER_SIZE];
+    kbd_tail++;
+    return (unsigned char)c;
+}
+
+/* Block until a key is typed; processes sleep, the boot stack halts */
+char keyboard_getc(void) {
+    uint32_t flags = irq_save();
+    while (kbd_tail == kbd_head) {
+        if (process_can_block())
+            process_wait_event(EVENT_KEYBOARD);
+        else
+            process_idle_wait();
+    }
+    irq_restore(flags);
+    return (char)keyboard_try_getc();
+}
+
+uint32_t keyboard_dropped(void) {
+    return kbd_dropped;
+}
@@ -0,0 +1,16 @@
+/* keyboard.h - PS/2 keyboard driver interface */
+#ifndef KEYBOARD_H
+#define KEYBOARD_H
+
+#include "types.h"
+
+/* Decoded character ring size (power of two) */
+#define KEYBOARD_BUFFER_SIZE 128
+
+void keyboard_initialize(void);
+char keyboard_getc(void);
+int keyboard_try_getc(void);
+int keyboard_available(int arg);
+uint32_t keyboard_dropped(void);
+
+#endif
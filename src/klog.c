@@ -0,0 +1,172 @@
+/* klog.c - Asynchronous kernel log ring with deferred serial flush */
+#include "klog.h"
+#include "kprintf.h"
+#include "serial.h"
+#include "interrupt.h"
+#include "timer.h"
+#include "cpu.h"
+#include "shell.h"
+
+typedef struct {
+    volatile uint32_t seq;      /* Ticket + 1 once the record is complete */
+    uint8_t level;
+    uint8_t len;
+    uint16_t reserved;
+    uint64_t tsc;               /* Timestamp taken when the slot was claimed */
+    char msg[KLOG_MSG_SIZE];
+} klog_record_t;
+
+static klog_record_t klog_ring[KLOG_ENTRIES];
+static volatile uint32_t klog_head = 0;      /* Next ticket to hand out */
+static volatile uint32_t klog_flushed = 0;   /* Next ticket to write to serial */
+static volatile uint32_t klog_drops = 0;
+static uint64_t klog_base_tsc = 0;
+static klog_output_t klog_output = NULL;   /* Replaces the console, e.g. a mux channel */
+static klog_space_t klog_output_space = NULL;
+static klog_output_t klog_mirror = NULL;   /* Extra sink for flushed records */
+
+static const char *klog_level_tag[] = { "ERR ", "WARN", "INFO", "DBG " };
+
+void klog_initialize(void) {
+    klog_base_tsc = rdtsc();
+}
+
+/* Send flushed records to 'output' instead of the console; NULL restores it */
+void klog_set_output(klog_output_t output, klog_space_t space) {
+    klog_output = output;
+    klog_output_space = space;
+}
+
+/* Copy every record written to serial to 'mirror' as well (NULL: off) */
+void klog_set_mirror(klog_output_t mirror) {
+    klog_mirror = mirror;
+}
+
+static void klog_emit(const char *line, size_t len) {
+    if (klog_output)
+        klog_output(line, len);
+    else
+        serial_write(line, len);
+    if (klog_mirror)
+        klog_mirror(line, len);
+}
+
+/*
+ * Claim a slot without locking: a compare-and-swap on the head ticket,
+ * retried if an interrupt handler logged in between. Records that have
+ * not reached the serial port yet are never overwritten; when the ring is
+ * full of them the new message is counted as dropped instead.
+ */
+void klog(int level, const char *fmt, ...) {
+    uint32_t ticket;
+    va_list args;
+
+    do {
+        ticket = klog_head;
+        if (ticket - klog_flushed >= KLOG_ENTRIES) {
+            __atomic_fetch_add(&klog_drops, 1, __ATOMIC_RELAXED);
+            return;
+        }
+    } while (!__atomic_compare_exchange_n(&klog_head, &ticket, ticket + 1, 0,
+                                          __ATOMIC_ACQUIRE, __ATOMIC_RELAXED));
+
+    klog_record_t *rec = &klog_ring[ticket % KLOG_ENTRIES];
+    rec->seq = 0;
+    rec->tsc = rdtsc();
+    rec->level = (uint8_t)level;
+
+    va_start(args, fmt);
+    int len = kvsnprintf(rec->msg, sizeof(rec->msg), fmt, args);
+    va_end(args);
+    rec->len = len < (int)sizeof(rec->msg) ? len : (int)sizeof(rec->msg) - 1;
+
+    __atomic_store_n(&rec->seq, ticket + 1, __ATOMIC_RELEASE);
+}
+
+/* Render one record as "[sec.usec] LEVEL message"; returns the length */
+static int klog_format(const klog_record_t *rec, char *buf, size_t size) {
+    uint32_t khz = timer_tsc_khz();
+    uint64_t us = khz ? div64_u32((rec->tsc - klog_base_tsc) * 1000, khz) : 0;
+    uint32_t sec = (uint32_t)div64_u32(us, 1000000);
+    uint32_t usec = (uint32_t)(us - (uint64_t)sec * 1000000);
+    int level = rec->level <= KLOG_DEBUG ? rec->level : KLOG_DEBUG;
+    int len = ksnprintf(buf, size, "[%5u.%06u] %s %s", sec, usec,
+                        klog_level_tag[level], rec->msg);
+
+    if (len >= (int)size - 1)
+        len = size - 2;
+    if (len > 0 && buf[len - 1] == '\n')
+        len--;
+    buf[len++] = '\n';
+    return len;
+}
+
+/*
+ * Write completed records to serial without blocking: stop at the first
+ * record still being filled in, or when the transmit ring lacks room.
+ * Meant for idle time, so a chatty subsystem never waits on the UART.
+ */
+void klog_flush(void) {
+    char line[KLOG_MSG_SIZE + 32];
+    uint32_t flags = irq_save();
+
+    while (klog_flushed != klog_head) {
+        klog_record_t *rec = &klog_ring[klog_flushed % KLOG_ENTRIES];
+        if (rec->seq != klog_flushed + 1)
+            break;
+
+        int len = klog_format(rec, line, sizeof(line));
+        /* Room for LF -> CR/LF, or for framing */
+        if ((klog_output ? klog_output_space() : serial_tx_space()) < (uint32_t)len * 2)
+            break;
+        klog_emit(line, len);
+        klog_flushed++;
+    }
+    irq_restore(flags);
+}
+
+/* Write everything that is pending, waiting for the UART as needed */
+void klog_sync(void) {
+    char line[KLOG_MSG_SIZE + 32];
+
+    while (klog_flushed != klog_head) {
+        klog_record_t *rec = &klog_ring[klog_flushed % KLOG_ENTRIES];
+        if (rec->seq != klog_flushed + 1)
+            break;
+
+        int len = klog_format(rec, line, sizeof(line));
+        klog_flushed++;
+        klog_emit(line, len);
+    }
+}
+
+/* Print every record still held in the ring, flushed or not */
+void klog_dmesg(void) {
+    char line[KLOG_MSG_SIZE + 32];
+    uint32_t head = klog_head;
+    uint32_t first = head > KLOG_ENTRIES ? head - KLOG_ENTRIES : 0;
+
+    for (uint32_t t = first; t != head; t++) {
+        klog_record_t *rec = &klog_ring[t % KLOG_ENTRIES];
+        if (rec->seq != t + 1)
+            continue;   /* Still being written, or already reused */
+
+        int len = klog_format(rec, line, sizeof(line));
+        if (rec->seq != t + 1)
+            continue;   /* Overwritten while we copied it */
+        serial_write(line, len);
+    }
+    kprintf("-- %u records, %u dropped --\n", head - first, klog_drops);
+}
+
+uint32_t klog_dropped(void) {
+    return klog_drops;
+}
+
+static int dmesg_command(int argc, char **argv) {
+    (void)argc;
+    (void)argv;
+    klog_dmesg();
+    return SHELL_OK;
+}
+SHELL_COMMAND("dmesg", dmesg_command, NULL, "Show the kernel log");
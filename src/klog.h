@@ -0,0 +1,28 @@
+/* klog.h - Asynchronous kernel log ring */
+#ifndef KLOG_H
+#define KLOG_H
+
+#include "types.h"
+
+/* Severity levels, most severe first */
+#define KLOG_ERR    0
+#define KLOG_WARN   1
+#define KLOG_INFO   2
+#define KLOG_DEBUG  3
+
+#define KLOG_ENTRIES   128     /* Ring capacity in records (power of two) */
+#define KLOG_MSG_SIZE  112     /* Longest message kept per record */
+
+typedef void (*klog_output_t)(const char *buf, size_t len);
+typedef uint32_t (*klog_space_t)(void);    /* Bytes the output takes without blocking */
+
+void klog_initialize(void);
+void klog_set_output(klog_output_t output, klog_space_t space);
+void klog_set_mirror(klog_output_t mirror);
+void klog(int level, const char *fmt, ...);
+void klog_flush(void);
+void klog_sync(void);
+void klog_dmesg(void);
+uint32_t klog_dropped(void);
+
+#endif
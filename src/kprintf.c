@@ -0,0 +1,216 @@
+/* kprintf.c - Formatted kernel output with table-driven integer conversion */
+#include "kprintf.h"
+#include "serial.h"
+#include "cpu.h"
+
+/* "00" "01" ... "99": two digits per division instead of one */
+static const char digit_pairs[201] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+
+typedef struct {
+    char *buf;
+    size_t size;
+    size_t len;      /* Characters produced, including any truncated */
+} out_t;
+
+static void out_char(out_t *out, char c) {
+    if (out->len + 1 < out->size)
+        out->buf[out->len] = c;
+    out->len++;
+}
+
+/* Write n in decimal so that it ends just before 'end'; returns the start */
+static char *format_u32(char *end, uint32_t n) {
+    char *p = end;
+
+    while (n >= 100) {
+        uint32_t pair = (n % 100) * 2;
+        n /= 100;
+        *--p = digit_pairs[pair + 1];
+        *--p = digit_pairs[pair];
+    }
+    if (n >= 10) {
+        *--p = digit_pairs[n * 2 + 1];
+        *--p = digit_pairs[n * 2];
+    } else {
+        *--p = '0' + n;
+    }
+    return p;
+}
+
+/* 64-bit values are split into base-10^9 chunks so only 32-bit math is used */
+static char *format_u64(char *end, uint64_t n) {
+    char *p = end;
+
+    while (n >> 32) {
+        uint64_t q = div64_u32(n, 1000000000);
+        uint32_t chunk = (uint32_t)(n - q * 1000000000);
+        char *chunk_start = format_u32(p, chunk);
+        while (chunk_start > p - 9)
+            *--chunk_start = '0';
+        p = chunk_start;
+        n = q;
+    }
+    return format_u32(p, (uint32_t)n);
+}
+
+static char *format_hex(char *end, uint64_t n, int upper) {
+    const char *digits = upper ? "0123456789ABCDEF" : "0123456789abcdef";
+    char *p = end;
+
+    do {
+        *--p = digits[n & 0xF];
+        n >>= 4;
+    } while (n);
+    return p;
+}
+
+static void out_field(out_t *out, const char *s, size_t len,
+                      int width, int left, char pad, char sign) {
+    int fill = width - (int)len - (sign ? 1 : 0);
+
+    /* With zero padding the sign goes before the zeros */
+    if (sign && pad == '0')
+        out_char(out, sign);
+    if (!left) {
+        while (fill-- > 0)
+            out_char(out, pad);
+    }
+    if (sign && pad != '0')
+        out_char(out, sign);
+    while (len--)
+        out_char(out, *s++);
+    if (left) {
+        while (fill-- > 0)
+            out_char(out, ' ');
+    }
+}
+
+int kvsnprintf(char *buf, size_t size, const char *fmt, va_list args) {
+    out_t out = { buf, size, 0 };
+    char num[24];
+    char *num_end = num + sizeof(num);
+
+    while (*fmt) {
+        if (*fmt != '%') {
+            out_char(&out, *fmt++);
+            continue;
+        }
+        fmt++;
+
+        int left = 0, width = 0, longlong = 0;
+        char pad = ' ';
+
+        for (;; fmt++) {
+            if (*fmt == '-')      left = 1;
+            else if (*fmt == '0') pad = '0';
+            else break;
+        }
+        while (*fmt >= '0' && *fmt <= '9')
+            width = width * 10 + (*fmt++ - '0');
+        if (left)
+            pad = ' ';
+        while (*fmt == 'l') {
+            longlong = (fmt[1] == 'l');
+            fmt += longlong ? 2 : 1;
+        }
+
+        char conv = *fmt;
+        if (conv == '\0')
+            break;
+        fmt++;
+
+        switch (conv) {
+            case 'd':
+            case 'i': {
+                int64_t v = longlong ? va_arg(args, int64_t) : va_arg(args, int32_t);
+                uint64_t mag = v < 0 ? -(uint64_t)v : (uint64_t)v;
+                char *s = format_u64(num_end, mag);
+                out_field(&out, s, num_end - s, width, left, pad, v < 0 ? '-' : 0);
+                break;
+            }
+            case 'u': {
+                char *s = longlong ? format_u64(num_end, va_arg(args, uint64_t))
+                                   : format_u32(num_end, va_arg(args, uint32_t));
+                out_field(&out, s, num_end - s, width, left, pad, 0);
+                break;
+            }
+            case 'x':
+            case 'X': {
+                uint64_t v = longlong ? va_arg(args, uint64_t) : va_arg(args, uint32_t);
+                char *s = format_hex(num_end, v, conv == 'X');
+                out_field(&out, s, num_end - s, width, left, pad, 0);
+                break;
+            }
+            case 'p': {
+                char *s = format_hex(num_end, (uint32_t)va_arg(args, void *), 1);
+                out_char(&out, '0');
+                out_char(&out, 'x');
+                out_field(&out, s, num_end - s, width > 2 ? width - 2 : 0, left, '0', 0);
+                break;
+            }
+            case 's': {
+                const char *s = va_arg(args, const char *);
+                size_t len = 0;
+                if (!s)
+                    s = "(null)";
+                while (s[len])
+                    len++;
+                out_field(&out, s, len, width, left, ' ', 0);
+                break;
+            }
+            case 'c': {
+                char c = (char)va_arg(args, int);
+                out_field(&out, &c, 1, width, left, ' ', 0);
+                break;
+            }
+            default:
+                out_char(&out, '%');
+                if (conv != '%')
+                    out_char(&out, conv);
+                break;
+        }
+    }
+
+    if (size > 0)
+        buf[out.len < size ? out.len : size - 1] = '\0';
+    return (int)out.len;
+}
+
+int ksnprintf(char *buf, size_t size, const char *fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    int len = kvsnprintf(buf, size, fmt, args);
+    va_end(args);
+    return len;
+}
+
+/*
+ * Format on the caller's stack and queue the result with one
+ * serial_write(), with the caller's interrupt state: a full ring is
+ * waited out on the transmit interrupt rather than drained by polling.
+ * serial_port_write() queues the whole message at once, so it is never
+ * split by another process's output.
+ */
+int kprintf(const char *fmt, ...) {
+    char buf[KPRINTF_BUFFER_SIZE];
+    va_list args;
+
+    va_start(args, fmt);
+    int len = kvsnprintf(buf, sizeof(buf), fmt, args);
+    va_end(args);
+
+    size_t emit = (size_t)len < sizeof(buf) ? (size_t)len : sizeof(buf) - 1;
+    serial_write(buf, emit);
+    return len;
+}
@@ -0,0 +1,24 @@
+/* kprintf.h - Formatted kernel output */
+#ifndef KPRINTF_H
+#define KPRINTF_H
+
+#include "types.h"
+
+typedef __builtin_va_list va_list;
+#define va_start(ap, last) __builtin_va_start(ap, last)
+#define va_arg(ap, type)   __builtin_va_arg(ap, type)
+#define va_end(ap)         __builtin_va_end(ap)
+
+/* Longest message kprintf emits in one piece; longer output is truncated */
+#define KPRINTF_BUFFER_SIZE 256
+
+/*
+ * Supported conversions: %d %i %u %x %X %p %s %c %%, with optional '-'
+ * and '0' flags, a field width, and the 'l' / 'll' length modifiers
+ * ('ll' takes a 64-bit argument).
+ */
+int kprintf(const char *fmt, ...);
+int ksnprintf(char *buf, size_t size, const char *fmt, ...);
+int kvsnprintf(char *buf, size_t size, const char *fmt, va_list args);
+
+#endif
@@ -1,7 +1,8 @@
 #include "memory.h"
-#include "serial.h"
-
-#define HEAP_SIZE 64*1024  // 64 KB heap size
+#include "klog.h"
+#include "kprintf.h"
+#include "interrupt.h"
+#include "shell.h"
 
 typedef struct mem_block
 {
@@ -10,21 +11,28 @@ typedef struct mem_block
     struct mem_block *next;
 } mem_block_t;
 
-static uint8_t heap[HEAP_SIZE];
 static mem_block_t *free_list = NULL;
+static size_t heap_size = 0;
 
-// Initialize the memory manager
-void memory_manager_initialize(void){
-    free_list = (mem_block_t*)heap;
-    free_list->size = HEAP_SIZE - sizeof(mem_block_t);
+// Initialize the memory manager over [base, base + size)
+void memory_manager_initialize(void *base, size_t size){
+    free_list = (mem_block_t*)base;
+    free_list->size = size - sizeof(mem_block_t);
     free_list->free = 1;
     free_list->next = NULL;
+    heap_size = size;
+
+    klog(KLOG_INFO, "Memory manager initialized (%u KB heap at %x)", size / 1024, (uint32_t)base);
+}
 
-    serial_puts("Memory manager initialized.\n");
+size_t memory_heap_size(void){
+    return heap_size;
 }
 
-// Allocate memory
+// Allocate memory; interrupts stay off while the list is changed, since
+// the timer may switch to another process that allocates too
 void *memory_allocate(size_t size){
+    uint32_t flags = irq_save();
     mem_block_t *current_block = free_list;
     size = (size + 3) & ~3; // Align size to 4 bytes
     while (current_block)
@@ -40,10 +48,12 @@ void *memory_allocate(size_t size){
                 current_block->size = size;
             }
             current_block->free = 0;
+            irq_restore(flags);
             return (uint8_t*)current_block + sizeof(mem_block_t);
         }
         current_block = current_block->next;
     }
+    irq_restore(flags);
     return NULL;
 }
 
@@ -52,6 +62,7 @@ void *memory_allocate(size_t size){
 void memory_deallocate(void *ptr){
     if (!ptr) return;
 
+    uint32_t flags = irq_save();
     mem_block_t* freed_block = (mem_block_t*)((uint8_t*)ptr - sizeof(mem_block_t));
     freed_block->free = 1;
 
@@ -64,5 +75,39 @@ void memory_deallocate(void *ptr){
             current_block = current_block->next;
         }
     }
+    irq_restore(flags);
 }
 
+// Walk the block list; headers count as neither used nor free
+void memory_get_stats(memory_stats_t *stats){
+    uint32_t flags = irq_save();
+    stats->heap_size = heap_size;
+    stats->used = stats->free = stats->largest_free = 0;
+    stats->blocks = stats->free_blocks = 0;
+
+    for (mem_block_t *block = free_list; block; block = block->next){
+        stats->blocks++;
+        if (block->free){
+            stats->free += block->size;
+            stats->free_blocks++;
+            if (block->size > stats->largest_free)
+                stats->largest_free = block->size;
+        }else{
+            stats->used += block->size;
+        }
+    }
+    irq_restore(flags);
+}
+
+static int mem_command(int argc, char **argv){
+    memory_stats_t st;
+    (void)argc;
+    (void)argv;
+
+    memory_get_stats(&st);
+    kprintf("Heap: %u KB, %u bytes used, %u free (largest %u)\n",
+            st.heap_size / 1024, st.used, st.free, st.largest_free);
+    kprintf("Blocks: %u, %u free\n", st.blocks, st.free_blocks);
+    return SHELL_OK;
+}
+SHELL_COMMAND("mem", mem_command, NULL, "Show memory statistics");
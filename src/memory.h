@@ -4,8 +4,14 @@
 
 #include "types.h"
 
-/* Memory manager initialization */
-void memory_manager_initialize(void);
+/* Heap size unless heap= on the command line says otherwise */
+#define DEFAULT_HEAP_SIZE  (64 * 1024)
+#define HEAP_SIZE_MIN      (4 * 1024)
+#define HEAP_SIZE_MAX      (256 * 1024 * 1024)
+
+/* Memory manager initialization: the heap is the given region */
+void memory_manager_initialize(void *base, size_t size);
+size_t memory_heap_size(void);
 
 /* Memory allocation */
 void *memory_allocate(size_t size);
@@ -13,4 +19,16 @@ void *memory_allocate(size_t size);
 /* Memory deallocation */
 void memory_deallocate(void *ptr);
 
+/* Heap occupancy from a walk of the block list */
+typedef struct {
+    size_t heap_size;
+    size_t used;            /* Payload bytes in allocated blocks */
+    size_t free;            /* Payload bytes in free blocks */
+    size_t largest_free;
+    uint32_t blocks;
+    uint32_t free_blocks;
+} memory_stats_t;
+
+void memory_get_stats(memory_stats_t *stats);
+
 #endif
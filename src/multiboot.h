@@ -0,0 +1,23 @@
+/* multiboot.h - Multiboot (v1) boot information */
+#ifndef MULTIBOOT_H
+#define MULTIBOOT_H
+
+#include "types.h"
+
+/* Value the loader leaves in EAX; boot.S passes it to kmain */
+#define MULTIBOOT_BOOTLOADER_MAGIC 0x2BADB002
+
+/* multiboot_info_t.flags: which fields below are valid */
+#define MULTIBOOT_INFO_MEMORY  0x001   /* mem_lower/mem_upper */
+#define MULTIBOOT_INFO_CMDLINE 0x004   /* cmdline */
+
+/* Leading fields of the boot information structure (the rest is unused) */
+typedef struct {
+    uint32_t flags;
+    uint32_t mem_lower;     /* KB of memory below 1 MB */
+    uint32_t mem_upper;     /* KB of memory from 1 MB up to the first hole */
+    uint32_t boot_device;
+    uint32_t cmdline;       /* Physical address of a NUL-terminated string */
+} multiboot_info_t;
+
+#endif
@@ -1,41 +1,38 @@
 /* process.c - Process Manager Implementation */
 #include "process.h"
 #include "serial.h"
+#include "kprintf.h"
 #include "memory.h"
-
-#define PROC_STACK_SIZE 4096
+#include "interrupt.h"
+#include "klog.h"
+#include "event.h"
+#include "cmdline.h"
+#include "initcall.h"
+#include "shell.h"
 
 pcb_t proctab[MAX_PROCS];  /* Global process table */
-static int32_t current_pid = -1;
+static int32_t current_pid = NULLPROC;
 pcb_t *currpid = NULL;
 
-/* -------------------------------------------------- */
-/* Utility                                            */
-/* -------------------------------------------------- */
+/* Boot-time settings from process_manager_initialize() */
+static int proc_limit = DEFAULT_MAX_PROCS;     /* Slots in use, <= MAX_PROCS */
+static uint32_t proc_stack_size = DEFAULT_PROC_STACK_SIZE;
+static int sched_policy = SCHED_PRIORITY;
 
-static void serial_put_int(int32_t num) {
-    char buf[12];
-    int i = 0;
-
-    if (num == 0) {
-        serial_putc('0');
-        return;
-    }
+/*
+ * Preemption: interrupt handlers only note that the scheduler should
+ * look again; process_preempt() acts on it on the way out of the
+ * interrupt, once the null process has taken over from kmain.
+ */
+#define RESCHED_WAKE     0x01   /* A process became ready */
+#define RESCHED_QUANTUM  0x02   /* The running process used up its slice */
 
-    if (num < 0) {
-        serial_putc('-');
-        num = -num;
-    }
+static volatile int resched_pending;
+static int preempt_enabled;
+static uint32_t sched_quantum = 2;
+static uint32_t quantum_left;
 
-    while (num > 0) {
-        buf[i++] = (num % 10) + '0';
-        num /= 10;
-    }
-
-    while (i--) {
-        serial_putc(buf[i]);
-    }
-}
+static sched_stats_t sched_stats;
 
 /* -------------------------------------------------- */
 /* SCHEDULER CODE */
@@ -44,138 +41,172 @@ static void serial_put_int(int32_t num) {
 /* Context switching with stack management */
 extern void ctxsw(uint32_t **old, uint32_t **new);
 
-void process_create_with_stack(void (*func)(void)) {
-    int available_pid;
-    
-    for (available_pid = 0; available_pid < MAX_PROCS; available_pid++) {
-        if (proctab[available_pid].state == PR_TERMINATED)
-            break;
-    }
-    
-    if (available_pid == MAX_PROCS)
-        return;
-    
-    /* Allocate stack for process */
-    uint32_t *process_stack = memory_allocate(PROC_STACK_SIZE);
-    if (!process_stack) {
-        serial_puts("Stack allocation failed.\n");
-        return;
-    }
-    
-    /* Set up stack pointer at top of stack */
-    uint32_t *stack_pointer = (uint32_t *)((uint32_t)process_stack + PROC_STACK_SIZE);
-    stack_pointer = (uint32_t *)((uint32_t)stack_pointer & ~0xF);  // 16-byte align
-    
-    /* Set up stack as if process was context-switched out */
-    *--stack_pointer = (uint32_t)process_terminate;  // Return address when func returns
-    *--stack_pointer = (uint32_t)func;               // Return address (where process starts)
-    *--stack_pointer = 0;                            // EBP
-    *--stack_pointer = 0;                            // EBX
-    *--stack_pointer = 0;                            // ESI
-    *--stack_pointer = 0;                            // EDI
-    *--stack_pointer = 0x0200;                       // EFLAGS (interrupts enabled)
-    
-    proctab[available_pid].pid = available_pid;
-    proctab[available_pid].state = PR_READY;
-    proctab[available_pid].entry = func;
-    proctab[available_pid].stack_base = process_stack;
-    proctab[available_pid].esp = stack_pointer;
-    proctab[available_pid].mem = process_stack;
-    proctab[available_pid].memsz = PROC_STACK_SIZE;
-    proctab[available_pid].priority = 1;
-    proctab[available_pid].dyn_priority = 1;
-}
-
+/*
+ * Pick the next process and switch to it. The null process is never
+ * picked while another one is ready. A process that is still running
+ * (preemption after a wakeup) keeps the CPU unless a ready one has a
+ * higher priority; under SCHED_ROUND_ROBIN it keeps it until its slice
+ * ends. Interrupts are off throughout; the process switched to restores
+ * its own EFLAGS.
+ */
 void scheduler_reschedule(void) {
+    uint32_t flags = irq_save();
     int previous_pid = current_pid;
     int next_pid = -1;
     int highest_priority = -1;
-    
-    /* Find highest priority READY process using round-robin for ties */
-    int start_search = (current_pid + 1) % MAX_PROCS;
-    for (int count = 0; count < MAX_PROCS; count++) {
-        int i = (start_search + count) % MAX_PROCS;
-        if (proctab[i].state == PR_READY) {
-            if (proctab[i].dyn_priority > highest_priority) {
-                highest_priority = proctab[i].dyn_priority;
-                next_pid = i;
-            }
+
+    /* Highest priority READY process, round-robin among ties; under
+     * SCHED_ROUND_ROBIN the first READY one after current wins */
+    int start_search = (current_pid + 1) % proc_limit;
+    for (int count = 0; count < proc_limit; count++) {
+        int i = (start_search + count) % proc_limit;
+        if (i == NULLPROC || proctab[i].state != PR_READY)
+            continue;
+        if (sched_policy == SCHED_ROUND_ROBIN) {
+            next_pid = i;
+            break;
+        }
+        if (proctab[i].dyn_priority > highest_priority) {
+            highest_priority = proctab[i].dyn_priority;
+            next_pid = i;
         }
     }
-    
-    /* No READY process found */
-    if (next_pid == -1) {
-        if (previous_pid >= 0 && proctab[previous_pid].state == PR_CURRENT)
-            return;
-        next_pid = 0;  // Fall back to idle process
+
+    if (proctab[previous_pid].state == PR_CURRENT && previous_pid != NULLPROC &&
+        (next_pid == -1 || sched_policy == SCHED_ROUND_ROBIN ||
+         highest_priority <= proctab[previous_pid].dyn_priority)) {
+        irq_restore(flags);
+        return;
     }
-    
+
+    /* Nothing else can run: the null process idles */
+    if (next_pid == -1)
+        next_pid = NULLPROC;
+
     /* Reset priority of scheduled process */
     proctab[next_pid].dyn_priority = proctab[next_pid].priority;
-    
+    quantum_left = sched_quantum;
+
     /* Same process, no switch needed */
-    if (next_pid == previous_pid && previous_pid >= 0)
+    if (next_pid == previous_pid) {
+        proctab[next_pid].state = PR_CURRENT;
+        irq_restore(flags);
         return;
-    
+    }
+
     /* Update states */
-    if (previous_pid >= 0 && proctab[previous_pid].state == PR_CURRENT)
+    if (proctab[previous_pid].state == PR_CURRENT)
         proctab[previous_pid].state = PR_READY;
-    
+
     proctab[next_pid].state = PR_CURRENT;
+    proctab[next_pid].switches++;
+    sched_stats.switches++;
     current_pid = next_pid;
     currpid = &proctab[next_pid];
-    
-    /* Context switch between processes */
+
+    /* Context switch between processes; an exited one saves into its own slot */
     ctxsw(&proctab[previous_pid].esp, &proctab[next_pid].esp);
+    irq_restore(flags);
 }
 
 void process_yield_cpu(void) {
-    if (currpid)
+    uint32_t flags = irq_save();
+    if (currpid && currpid->state == PR_CURRENT)
         currpid->state = PR_READY;
     scheduler_reschedule();
+    irq_restore(flags);
 }
 
 void scheduler_update_aging(void) {
     /* Increase priority of waiting processes to prevent starvation */
-    for (int i = 0; i < MAX_PROCS; i++) {
-        if (proctab[i].state == PR_READY) {
+    for (int i = 0; i < proc_limit; i++) {
+        if (i != NULLPROC && proctab[i].state == PR_READY) {
             proctab[i].dyn_priority++;
         }
     }
 }
 
+/* Called at the end of every interrupt, with interrupts disabled */
+void process_preempt(void) {
+    int reason = resched_pending;
+
+    if (!reason || !preempt_enabled)
+        return;
+    resched_pending = 0;
+    if (reason & RESCHED_QUANTUM) {
+        scheduler_update_aging();
+        process_yield_cpu();
+    } else {
+        scheduler_reschedule();
+    }
+}
+
 void process_sleep(int tick_count) {
-    if (tick_count <= 0 || currpid == NULL) return;
+    if (tick_count <= 0 || !process_can_block()) return;
+
+    uint32_t flags = irq_save();
     currpid->sleep_ticks = tick_count;
     currpid->state = PR_SLEEP;
     scheduler_reschedule();
+    irq_restore(flags);
 }
 
+/* Timer interrupt: wake sleepers and charge the tick and slice to the running process */
 void process_timer_tick(void) {
-    for (int i = 0; i < MAX_PROCS; i++) {
+    uint32_t ready = 0;
+
+    for (int i = 0; i < proc_limit; i++) {
         if (proctab[i].state == PR_SLEEP) {
             proctab[i].sleep_ticks--;
             if (proctab[i].sleep_ticks <= 0) {
                 proctab[i].state = PR_READY;
+                resched_pending |= RESCHED_WAKE;
             }
         }
+        if (i != NULLPROC && proctab[i].state == PR_READY)
+            ready++;
     }
+    if (currpid)
+        currpid->cpu_ticks++;
+    sched_stats.ticks++;
+    sched_stats.runq_ticks += ready;
+    if (current_pid != NULLPROC && quantum_left > 0 && --quantum_left == 0)
+        resched_pending |= RESCHED_QUANTUM;
+}
+
+/*
+ * Idle-time work, then halt until the next interrupt. Called with
+ * interrupts disabled; returns with them disabled again.
+ */
+void process_idle_wait(void) {
+    klog_flush();
+    cpu_idle();
+    interrupts_disable();
+}
+
+/* Only processes running on their own stack can be switched away from */
+int process_can_block(void) {
+    return currpid != NULL && currpid->stack_base != NULL;
 }
 
 void process_wait_event(int event_id) {
+    uint32_t flags = irq_save();
     currpid->wait_event = event_id;
     currpid->state = PR_WAIT;
     scheduler_reschedule();
+    irq_restore(flags);
 }
 
 void process_wakeup_event(int event_id) {
-    for (int i = 0; i < MAX_PROCS; i++) {
+    for (int i = 0; i < proc_limit; i++) {
         if (proctab[i].state == PR_WAIT &&
             proctab[i].wait_event == event_id) {
             proctab[i].wait_event = -1;
             proctab[i].state = PR_READY;
+            resched_pending |= RESCHED_WAKE;
         }
     }
+    event_wakeup_sets(event_id);
 }
 
 
@@ -183,96 +214,242 @@ void process_wakeup_event(int event_id) {
 /* Process Manager Init                               */
 /* -------------------------------------------------- */
 
-void process_scheduler_start(void) {
-    serial_puts("\n=== Running Processes Sequentially ===\n\n");
-    
-    /* Run each ready process to completion */
-    for (int i = 0; i < MAX_PROCS; i++) {
-        if (proctab[i].state == PR_READY && proctab[i].entry != NULL) {
-            serial_puts("Starting process ");
-            serial_put_int(i);
-            serial_puts("...\n");
-            
-            proctab[i].state = PR_CURRENT;
-            current_pid = i;
-            currpid = &proctab[i];
-            
-            /* Call the process function directly */
-            proctab[i].entry();
-            
-            /* Mark as completed */
-            proctab[i].state = PR_TERMINATED;
-            
-            serial_puts("\n");
-        }
-    }
-    
-    serial_puts("=== All Processes Completed! ===\n");
-    serial_puts("Returning to shell...\n\n");
-    
-    /* Return to shell instead of hanging */
-}
-
-void process_manager_initialize(void) {
+/*
+ * The caller becomes the null process (pid 0): it keeps running on the
+ * boot stack and is what the scheduler falls back to when nothing else
+ * is ready.
+ */
+void process_manager_initialize(int max_procs, uint32_t stack_size, int policy) {
     for (int i = 0; i < MAX_PROCS; i++) {
         proctab[i].pid = -1;
         proctab[i].state = PR_TERMINATED;
+        proctab[i].name = NULL;
+        proctab[i].flags = 0;
         proctab[i].entry = NULL;
+        proctab[i].arg = NULL;
         proctab[i].stack_base = NULL;
         proctab[i].esp = NULL;
         proctab[i].mem = NULL;
         proctab[i].memsz = 0;
         proctab[i].sleep_ticks = 0;
         proctab[i].wait_event = -1;
-        proctab[i].priority = 1;
-        proctab[i].dyn_priority = 1;
+        proctab[i].priority = PRIO_DEFAULT;
+        proctab[i].dyn_priority = PRIO_DEFAULT;
+        proctab[i].cpu_ticks = 0;
+        proctab[i].switches = 0;
     }
+    proctab[NULLPROC].pid = NULLPROC;
+    proctab[NULLPROC].state = PR_CURRENT;
+    proctab[NULLPROC].name = "null";
+    proctab[NULLPROC].flags = PROC_F_KERNEL;
+    proctab[NULLPROC].priority = PRIO_NULL;
+    proctab[NULLPROC].dyn_priority = PRIO_NULL;
+
+    current_pid = NULLPROC;
+    currpid = &proctab[NULLPROC];
+    resched_pending = 0;
+    sched_stats.ticks = 0;
+    sched_stats.runq_ticks = 0;
+    sched_stats.switches = 0;
+    quantum_left = 0;
+    proc_limit = (max_procs < PROC_LIMIT_MIN || max_procs > MAX_PROCS) ? MAX_PROCS : max_procs;
+    proc_stack_size = stack_size;
+    sched_policy = policy;
+
+    klog(KLOG_INFO, "Process manager initialized (%d slots, %u byte stacks, %s)",
+         proc_limit, proc_stack_size, policy == SCHED_ROUND_ROBIN ? "round-robin" : "priority");
+}
+
+void process_get_sched_stats(sched_stats_t *stats) {
+    uint32_t flags = irq_save();
+    *stats = sched_stats;
+    irq_restore(flags);
+}
+
+int process_max(void) {
+    return proc_limit;
+}
 
-    serial_puts("Process manager initialized.\n");
+void process_set_quantum(uint32_t ticks) {
+    sched_quantum = ticks ? ticks : 1;
+}
+
+/* Stacks for new processes come from the heap */
+static int process_init(void) {
+    process_manager_initialize(boot_config.max_procs, boot_config.proc_stack_size,
+                               boot_config.sched_policy);
+    process_set_quantum(boot_config.timer_hz * SCHED_QUANTUM_MS / 1000);
+    return 0;
+}
+INITCALL("process", process_init, INIT_LEVEL_KERNEL, "memory");
+
+/*
+ * kmain ends here: from now on interrupts may switch processes, and
+ * the boot context only runs when nothing else is ready. It frees the
+ * stacks of exited processes and drains the kernel log, then halts.
+ */
+void process_null_loop(void) {
+    interrupts_disable();
+    preempt_enabled = 1;
+    scheduler_reschedule();
+    for (;;) {
+        process_reap();
+        process_idle_wait();
+    }
 }
 
 /* -------------------------------------------------- */
 /* Process Creation                                   */
 /* -------------------------------------------------- */
 
-int32_t process_create(void (*func)(void)) {
+/*
+ * Create a READY process running func on a stack of its own. The stack
+ * is laid out as if the process had been switched out by ctxsw(): the
+ * saved registers, then func as the return address, then process_exit
+ * for func to return into. Returns the pid, or -1.
+ */
+int32_t process_spawn(const process_attr_t *attr, void (*func)(void), void *arg) {
+    static const process_attr_t defaults = { NULL, 0, 0, 0 };
     int available_pid;
 
-    for (available_pid = 0; available_pid < MAX_PROCS; available_pid++) {
+    if (!attr)
+        attr = &defaults;
+    uint32_t stack_size = attr->stack_size ? attr->stack_size : proc_stack_size;
+
+    uint32_t flags = irq_save();
+    for (available_pid = 1; available_pid < proc_limit; available_pid++) {
         if (proctab[available_pid].state == PR_TERMINATED)
             break;
     }
-
-    if (available_pid == MAX_PROCS)
+    
+    if (available_pid >= proc_limit) {
+        irq_restore(flags);
         return -1;
+    }
 
-    /* Simple process setup - no stack switching needed */
+    /* An exited process may still hold its stack */
+    memory_deallocate(proctab[available_pid].stack_base);
+    proctab[available_pid].stack_base = NULL;
+    
+    /* Allocate stack for process */
+    uint32_t *process_stack = memory_allocate(stack_size);
+    if (!process_stack) {
+        irq_restore(flags);
+        klog(KLOG_ERR, "Stack allocation failed for new process");
+        return -1;
+    }
+    
+    /* Set up stack pointer at top of stack */
+    uint32_t *stack_pointer = (uint32_t *)((uint32_t)process_stack + stack_size);
+    stack_pointer = (uint32_t *)((uint32_t)stack_pointer & ~0xF);  // 16-byte align
+    
+    /* Set up stack as if process was context-switched out */
+    *--stack_pointer = (uint32_t)process_exit;       // Return address when func returns
+    *--stack_pointer = (uint32_t)func;               // Return address (where process starts)
+    *--stack_pointer = 0;                            // EBP (ends frame-pointer unwinding)
+    *--stack_pointer = 0;                            // EBX
+    *--stack_pointer = 0;                            // ESI
+    *--stack_pointer = 0;                            // EDI
+    *--stack_pointer = EFLAGS_IF;                    // EFLAGS (interrupts enabled)
+    
     proctab[available_pid].pid = available_pid;
-    proctab[available_pid].state = PR_READY;
+    proctab[available_pid].name = attr->name;
+    proctab[available_pid].flags = attr->flags;
     proctab[available_pid].entry = func;
-    proctab[available_pid].stack_base = NULL;
-    proctab[available_pid].esp = NULL;
-    proctab[available_pid].mem = NULL;
-    proctab[available_pid].memsz = 0;
-    proctab[available_pid].priority = 1;
-    proctab[available_pid].dyn_priority = 1;
-
-    serial_puts("Process created with PID: ");
-    serial_put_int(available_pid);
-    serial_puts("\n");
+    proctab[available_pid].arg = arg;
+    proctab[available_pid].stack_base = process_stack;
+    proctab[available_pid].esp = stack_pointer;
+    proctab[available_pid].mem = process_stack;
+    proctab[available_pid].memsz = stack_size;
+    proctab[available_pid].sleep_ticks = 0;
+    proctab[available_pid].wait_event = -1;
+    proctab[available_pid].priority = attr->priority ? attr->priority : PRIO_DEFAULT;
+    proctab[available_pid].dyn_priority = proctab[available_pid].priority;
+    proctab[available_pid].cpu_ticks = 0;
+    proctab[available_pid].switches = 0;
+    proctab[available_pid].state = PR_READY;
+    resched_pending |= RESCHED_WAKE;
+    irq_restore(flags);
 
     return available_pid;
 }
 
+int32_t process_create(void (*func)(void)) {
+    int32_t pid = process_spawn(NULL, func, NULL);
+
+    if (pid >= 0)
+        klog(KLOG_INFO, "Process created with PID: %d", pid);
+    return pid;
+}
+
+/* The arg passed to process_spawn() for the running process */
+void *process_arg(void) {
+    return currpid ? currpid->arg : NULL;
+}
+
 /* -------------------------------------------------- */
 /* Process Exit                                       */
 /* -------------------------------------------------- */
 
-void process_terminate(void) {
-    if (currpid) {
-        proctab[currpid->pid].state = PR_TERMINATED;
-        currpid = NULL;
-        current_pid = -1;
+/*
+ * End the running process; also where an entry function returns to.
+ * The stack stays allocated until another process reaps it, since this
+ * code is still running on it.
+ */
+void process_exit(void) {
+    interrupts_disable();
+    currpid->state = PR_TERMINATED;
+    scheduler_reschedule();
+    for (;;)
+        cpu_idle();     /* Not reached: nothing switches back to us */
+}
+
+/*
+ * Terminate another process, or the caller; returns -1 for a bad pid.
+ * Kernel services (PROC_F_KERNEL) are refused: without the shell or
+ * klogd the system cannot be driven or drains its log only when idle.
+ */
+int process_kill(int32_t pid) {
+    if (pid <= NULLPROC || pid >= proc_limit || proctab[pid].state == PR_TERMINATED ||
+        (proctab[pid].flags & PROC_F_KERNEL))
+        return -1;
+    if (pid == current_pid)
+        process_exit();
+
+    uint32_t flags = irq_save();
+    proctab[pid].state = PR_TERMINATED;
+    proctab[pid].wait_event = -1;
+    irq_restore(flags);
+    return 0;
+}
+
+/* Free the stacks of processes that have exited */
+void process_reap(void) {
+    uint32_t flags = irq_save();
+
+    for (int i = 1; i < proc_limit; i++) {
+        if (proctab[i].state == PR_TERMINATED && proctab[i].stack_base && i != current_pid) {
+            memory_deallocate(proctab[i].stack_base);
+            proctab[i].stack_base = NULL;
+            proctab[i].mem = NULL;
+        }
+    }
+    irq_restore(flags);
+}
+
+/* Block until every process other than kernel services has exited */
+void process_wait_all(void) {
+    for (;;) {
+        int remaining = 0;
+
+        for (int i = 1; i < proc_limit; i++) {
+            if (i != current_pid && proctab[i].state != PR_TERMINATED &&
+                !(proctab[i].flags & PROC_F_KERNEL))
+                remaining++;
+        }
+        if (remaining == 0 || !process_can_block())
+            return;
+        process_sleep(1);
     }
 }
 
@@ -280,26 +457,41 @@ void process_terminate(void) {
 /* Process List                                       */
 /* -------------------------------------------------- */
 
+const char *process_state_name(proc_state_t state) {
+    switch (state) {
+        case PR_CURRENT: return "RUNNING";
+        case PR_READY:   return "READY";
+        case PR_SLEEP:   return "SLEEP";
+        case PR_WAIT:    return "WAIT";
+        default:         return "UNKNOWN";
+    }
+}
+
 void process_list_display(void) {
-    serial_puts("PID\tSTATE\n");
-    serial_puts("----------------\n");
+    serial_puts("PID\tSTATE\tPRIO\tNAME\n");
+    serial_puts("--------------------------------\n");
 
-    for (int i = 0; i < MAX_PROCS; i++) {
+    for (int i = 0; i < proc_limit; i++) {
         if (proctab[i].state != PR_TERMINATED) {
-            serial_put_int(i);
-            serial_puts("\t");
-
-            switch (proctab[i].state) {
-                case PR_CURRENT: serial_puts("RUNNING"); break;
-                case PR_READY:   serial_puts("READY");   break;
-                case PR_SLEEP:   serial_puts("SLEEP");   break;
-                case PR_WAIT:    serial_puts("WAIT");    break;
-                default:         serial_puts("UNKNOWN"); break;
-            }
-
-            serial_puts("\n");
+            kprintf("%d\t%s\t%d/%d\t%s\n", i, process_state_name(proctab[i].state),
+                    proctab[i].priority, proctab[i].dyn_priority,
+                    proctab[i].name ? proctab[i].name : "-");
         }
     }
     serial_puts("\n");
 }
 
+static int kill_command(int argc, char **argv) {
+    uint32_t pid;
+
+    if (argc != 2 || cmdline_parse_number(argv[1], &pid) != 0)
+        return SHELL_USAGE;
+    if (pid < (uint32_t)proc_limit && proctab[pid].state != PR_TERMINATED &&
+        (proctab[pid].flags & PROC_F_KERNEL))
+        kprintf("kill: pid %u (%s) is a kernel service\n", pid,
+                proctab[pid].name ? proctab[pid].name : "-");
+    else if ((int32_t)pid == current_pid || process_kill((int32_t)pid) != 0)
+        kprintf("kill: no process %u to stop\n", pid);
+    return SHELL_OK;
+}
+SHELL_COMMAND("kill", kill_command, "<pid>", "Terminate a process");
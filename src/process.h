@@ -4,8 +4,30 @@
 
 #include "types.h"
 
-/* Maximum number of processes */
-#define MAX_PROCS 16
+/* Process table capacity; procs= on the command line sets how many are used */
+#define MAX_PROCS 64
+#define DEFAULT_MAX_PROCS 16
+#define PROC_LIMIT_MIN    2     /* The null process and one more */
+
+/* pid 0 is the null process: the boot context, run when nothing else can */
+#define NULLPROC 0
+
+/* Per-process stack size, settable with stack= */
+#define DEFAULT_PROC_STACK_SIZE 4096
+#define PROC_STACK_SIZE_MIN     1024
+#define PROC_STACK_SIZE_MAX     (64 * 1024)
+
+/* Base priorities; higher runs first, the null process only when idle */
+#define PRIO_NULL     0
+#define PRIO_DEFAULT  1
+#define PRIO_SHELL    4
+
+/* Time slice before a running process is preempted */
+#define SCHED_QUANTUM_MS  20
+
+/* Scheduling policies (sched=prio|rr) */
+#define SCHED_PRIORITY     0   /* Highest aged priority, round-robin among ties */
+#define SCHED_ROUND_ROBIN  1   /* Next ready process in table order */
 
 /* Process states */
 typedef enum {
@@ -16,11 +38,24 @@ typedef enum {
     PR_WAIT         /* Process is waiting for event */
 } proc_state_t;
 
+/* Well-known event IDs for process_wait_event() */
+#define EVENT_SERIAL_RX     1   /* + port (0-3): byte available on that COM port */
+#define EVENT_KEYBOARD      5   /* Character in the keyboard ring */
+#define EVENT_CONSOLE_INPUT 6   /* Either of the console inputs above */
+#define EVENT_OBJECT_BASE   16  /* Counters and timers from event.c */
+#define EVENT_SET_BASE      64  /* Processes blocked in event_set_wait() */
+
+/* Process flags */
+#define PROC_F_KERNEL  0x01     /* Kernel service (null, shell, klogd): 'run' does not wait for it */
+
 /* Process Control Block (PCB) */
 typedef struct {
     int32_t pid;           /* Process ID */
     proc_state_t state;    /* Current state */
+    const char *name;      /* Shown by ps; NULL for unnamed */
+    uint32_t flags;        /* PROC_F_* */
     void (*entry)(void);   /* Entry point function */
+    void *arg;             /* process_arg() for the entry function */
     void *stack_base;      /* Stack base address */
     uint32_t *esp;         /* Saved stack pointer */
     void *mem;             /* Allocated memory pointer */
@@ -29,8 +64,25 @@ typedef struct {
     int wait_event;        /* Event ID for wait */
     int priority;          /* Base priority */
     int dyn_priority;      /* Dynamic priority (for aging) */
+    uint32_t cpu_ticks;    /* Timer ticks taken while running */
+    uint32_t switches;     /* Times switched to */
 } pcb_t;
 
+/* Settings for process_spawn(); zero fields take the defaults */
+typedef struct {
+    const char *name;
+    int priority;          /* 0: PRIO_DEFAULT */
+    uint32_t stack_size;   /* 0: the stack= setting */
+    uint32_t flags;
+} process_attr_t;
+
+/* Scheduler counters since process_manager_initialize(), for top */
+typedef struct {
+    uint32_t ticks;        /* Timer ticks */
+    uint32_t runq_ticks;   /* READY processes, summed over the ticks */
+    uint32_t switches;     /* Context switches */
+} sched_stats_t;
+
 /* Global current process pointer */
 extern pcb_t *currpid;
 
@@ -38,10 +90,29 @@ extern pcb_t *currpid;
 extern pcb_t proctab[MAX_PROCS];
 
 /* Process manager functions */
-void process_manager_initialize(void);
-void process_scheduler_start(void);
+void process_manager_initialize(int max_procs, uint32_t stack_size, int policy);
+int process_max(void);
+void process_get_sched_stats(sched_stats_t *stats);
+void process_set_quantum(uint32_t ticks);
+void process_null_loop(void) __attribute__((noreturn));
+int32_t process_spawn(const process_attr_t *attr, void (*func)(void), void *arg);
 int32_t process_create(void (*func)(void));
-void process_terminate(void);
+void *process_arg(void);
+void process_exit(void) __attribute__((noreturn));
+int process_kill(int32_t pid);
+void process_reap(void);
+void process_wait_all(void);
 void process_list_display(void);
+const char *process_state_name(proc_state_t state);
+
+/* Blocking and wakeup */
+int process_can_block(void);
+void process_idle_wait(void);
+void process_yield_cpu(void);
+void process_preempt(void);
+void process_sleep(int tick_count);
+void process_timer_tick(void);
+void process_wait_event(int event_id);
+void process_wakeup_event(int event_id);
 
 #endif
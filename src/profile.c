@@ -0,0 +1,233 @@
+/* profile.c - Statistical sampling profiler on the RTC periodic interrupt */
+#include "profile.h"
+#include "interrupt.h"
+#include "process.h"
+#include "kprintf.h"
+#include "klog.h"
+#include "io.h"
+#include "string.h"
+#include "cmdline.h"
+#include "shell.h"
+
+#define CMOS_INDEX    0x70
+#define CMOS_DATA     0x71
+#define CMOS_NMI_OFF  0x80      /* Keep NMI masked while the index is set */
+#define RTC_REG_A     0x0A      /* Bits 0-3: periodic rate */
+#define RTC_REG_B     0x0B
+#define RTC_REG_C     0x0C      /* Interrupt flags; reading re-arms the IRQ */
+#define RTC_B_PIE     0x40      /* Periodic interrupt enable */
+#define RTC_BASE_HZ   32768u
+
+/*
+ * Samples go into a histogram keyed by (stack, PID) rather than a trace:
+ * a hot loop costs one bucket however long it runs. The table is open
+ * addressed; each new stack is appended once to a shared frame pool.
+ * When PROFILE_PROBES slots are taken or the pool is full the sample is
+ * counted as dropped.
+ */
+typedef struct {
+    uint32_t hash;
+    int32_t pid;            /* 0: idle; -1: before process_manager_initialize */
+    uint32_t count;
+    uint16_t frames;        /* Offset into pool */
+    uint16_t depth;
+} profile_bucket_t;
+
+static profile_bucket_t buckets[PROFILE_BUCKETS];
+static uint32_t pool[PROFILE_POOL_WORDS];
+static uint32_t pool_used;
+static uint32_t samples;
+static uint32_t dropped;
+static uint32_t sample_hz;
+static volatile int running;
+static int handler_installed;
+
+static uint8_t cmos_read(uint8_t reg) {
+    outb(CMOS_INDEX, CMOS_NMI_OFF | reg);
+    return inb(CMOS_DATA);
+}
+
+static void cmos_write(uint8_t reg, uint8_t value) {
+    outb(CMOS_INDEX, CMOS_NMI_OFF | reg);
+    outb(CMOS_DATA, value);
+}
+
+static int same_stack(const profile_bucket_t *b, const uint32_t *stack, int depth) {
+    if (b->depth != depth)
+        return 0;
+    for (int i = 0; i < depth; i++) {
+        if (pool[b->frames + i] != stack[i])
+            return 0;
+    }
+    return 1;
+}
+
+static void profile_record(const uint32_t *stack, int depth, int32_t pid) {
+    uint32_t hash = (uint32_t)pid * 0x9E3779B9u;
+
+    for (int i = 0; i < depth; i++)
+        hash = (hash ^ stack[i]) * 16777619u;
+
+    uint32_t slot = (hash * 2654435761u) >> 21;
+    for (int probe = 0; probe < PROFILE_PROBES; probe++) {
+        profile_bucket_t *b = &buckets[(slot + probe) & (PROFILE_BUCKETS - 1)];
+        if (b->count == 0) {
+            if (pool_used + depth > PROFILE_POOL_WORDS)
+                break;
+            b->hash = hash;
+            b->pid = pid;
+            b->depth = depth;
+            b->frames = pool_used;
+            for (int i = 0; i < depth; i++)
+                pool[pool_used++] = stack[i];
+        } else if (b->hash != hash || b->pid != pid || !same_stack(b, stack, depth)) {
+            continue;
+        }
+        b->count++;
+        return;
+    }
+    dropped++;
+}
+
+/*
+ * Interrupted EIP, then return addresses from the EBP chain. Without
+ * paging any address reads safely, so the walk only has to stop at
+ * implausible frames: EBP must be aligned and move up the stack by less
+ * than PROFILE_MAX_FRAME, and each return address must lie in .text.
+ * boot.S and new process stacks start the chain with EBP = 0. A sample
+ * taken inside a prologue, before EBP is set up, misses the caller.
+ */
+static int profile_unwind(const interrupt_frame_t *frame, uint32_t *stack) {
+    int depth = 0;
+
+    stack[depth++] = frame->eip;
+#ifdef PROFILE_FRAMES
+    extern char __text_start[], __text_end[];
+    uint32_t ebp = frame->ebp;
+
+    while (depth < PROFILE_DEPTH && ebp != 0 && (ebp & 3) == 0) {
+        const uint32_t *fp = (const uint32_t *)ebp;
+        uint32_t ret = fp[1];
+        if (ret < (uint32_t)__text_start || ret >= (uint32_t)__text_end)
+            break;
+        stack[depth++] = ret;
+        if (fp[0] <= ebp || fp[0] - ebp > PROFILE_MAX_FRAME)
+            break;
+        ebp = fp[0];
+    }
+#endif
+    return depth;
+}
+
+/* Interrupt gate: runs with IRQs off, so the histogram needs no lock */
+static void profile_irq_handler(interrupt_frame_t *frame) {
+    uint32_t stack[PROFILE_DEPTH];
+
+    cmos_read(RTC_REG_C);
+    if (!running)
+        return;
+    samples++;
+    profile_record(stack, profile_unwind(frame, stack), currpid ? currpid->pid : -1);
+}
+
+/*
+ * Clear the histogram and sample at hz, rounded up to a power of two:
+ * the RTC's periodic rate r gives 32768 >> (r - 1) Hz. Code that runs with
+ * interrupts disabled is charged to the instruction that re-enables them.
+ */
+int profile_start(uint32_t hz) {
+    uint32_t rate = 1;
+
+    if (hz < 2)
+        hz = 2;
+    if (hz > PROFILE_MAX_HZ)
+        hz = PROFILE_MAX_HZ;
+    while ((RTC_BASE_HZ >> rate) >= hz)
+        rate++;
+
+    uint32_t flags = irq_save();
+    for (int i = 0; i < PROFILE_BUCKETS; i++)
+        buckets[i].count = 0;
+    pool_used = 0;
+    samples = 0;
+    dropped = 0;
+    sample_hz = RTC_BASE_HZ >> (rate - 1);
+
+    if (!handler_installed) {
+        irq_install_handler(IRQ_RTC, profile_irq_handler);
+        handler_installed = 1;
+    }
+    cmos_write(RTC_REG_A, (cmos_read(RTC_REG_A) & 0xF0) | rate);
+    cmos_write(RTC_REG_B, cmos_read(RTC_REG_B) | RTC_B_PIE);
+    cmos_read(RTC_REG_C);
+    running = 1;
+    irq_enable(IRQ_RTC);
+    irq_restore(flags);
+
+    klog(KLOG_INFO, "Profiler sampling at %u Hz", sample_hz);
+    return 0;
+}
+
+void profile_stop(void) {
+    uint32_t flags = irq_save();
+    running = 0;
+    cmos_write(RTC_REG_B, cmos_read(RTC_REG_B) & ~RTC_B_PIE);
+    irq_disable_line(IRQ_RTC);
+    irq_restore(flags);
+}
+
+void profile_status(void) {
+    uint32_t used = 0;
+
+    for (int i = 0; i < PROFILE_BUCKETS; i++)
+        used += buckets[i].count != 0;
+    kprintf("Profiler %s: %u samples at %u Hz, %u/%u buckets, %u/%u frames, "
+            "%u dropped, depth %u\n", running ? "running" : "stopped", samples,
+            sample_hz, used, PROFILE_BUCKETS, pool_used, PROFILE_POOL_WORDS, dropped,
+            PROFILE_DEPTH);
+}
+
+/*
+ * One "PROF <count> <pid> <eip> [<return address> ...]" line per bucket
+ * between PROF-BEGIN and PROF-END, for tools/profsym.py. Sampling pauses
+ * while the dump runs so the console output does not profile itself.
+ */
+void profile_dump(void) {
+    int was_running = running;
+
+    running = 0;
+    kprintf("PROF-BEGIN hz=%u samples=%u dropped=%u depth=%u\n", sample_hz, samples,
+            dropped, PROFILE_DEPTH);
+    for (int i = 0; i < PROFILE_BUCKETS; i++) {
+        const profile_bucket_t *b = &buckets[i];
+        if (!b->count)
+            continue;
+        kprintf("PROF %u %d", b->count, b->pid);
+        for (int f = 0; f < b->depth; f++)
+            kprintf(" %08x", pool[b->frames + f]);
+        kprintf("\n");
+    }
+    kprintf("PROF-END\n");
+    running = was_running;
+}
+
+static int profile_command(int argc, char **argv) {
+    uint32_t hz = PROFILE_DEFAULT_HZ;
+
+    if (argc == 1) {
+        profile_status();
+    } else if (strcmp(argv[1], "start") == 0 && argc <= 3) {
+        if (argc == 3 && cmdline_parse_number(argv[2], &hz) != 0)
+            return SHELL_USAGE;
+        profile_start(hz);
+    } else if (strcmp(argv[1], "stop") == 0 && argc == 2) {
+        profile_stop();
+        profile_status();
+    } else if (strcmp(argv[1], "dump") == 0 && argc == 2) {
+        profile_dump();
+    } else {
+        return SHELL_USAGE;
+    }
+    return SHELL_OK;
+}
+SHELL_COMMAND("profile", profile_command, "[start [hz]|stop|dump]", "Sampling profiler status and control");
@@ -0,0 +1,27 @@
+/* profile.h - Statistical sampling profiler */
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include "types.h"
+
+#define PROFILE_BUCKETS     2048    /* Distinct (stack, PID) samples kept (power of two) */
+#define PROFILE_PROBES      16      /* Hash probes before a sample is dropped */
+#define PROFILE_POOL_WORDS  8192    /* Frame addresses shared by all buckets */
+#define PROFILE_MAX_FRAME   65536   /* Largest stack frame the unwinder accepts */
+
+/* Frames per sample, EIP included; make PROFILE=1 builds with frame
+ * pointers so the sampler can follow the EBP chain */
+#ifdef PROFILE_FRAMES
+#define PROFILE_DEPTH       8
+#else
+#define PROFILE_DEPTH       1
+#endif
+#define PROFILE_DEFAULT_HZ  1024
+#define PROFILE_MAX_HZ      8192    /* RTC periodic rates are 2..8192 Hz */
+
+int profile_start(uint32_t hz);
+void profile_stop(void);
+void profile_status(void);
+void profile_dump(void);
+
+#endif
@@ -8,7 +8,7 @@ void scheduler_initialize(void){
 
 void scheduler_start(void){
     serial_puts("Scheduler started.\n");
-    process_scheduler_start();
+    process_wait_all();
 }
 
 void scheduler_yield(void){
@@ -1,8 +1,73 @@
-/* serial.c - Serial port driver (COM1) */
+/* serial.c - Serial port driver (COM1-COM4) */
 #include "serial.h"
+#include "interrupt.h"
+#include "process.h"
+#include "event.h"
+#include "string.h"
 #include "io.h"
+#include "klog.h"
+#include "initcall.h"
 
-#define COM1 0x3F8   /* I/O port base address for COM1 */
+#define UART_CLOCK_BAUD 115200  /* Baud rate at divisor 1 */
+#define UART_FIFO_SIZE 16       /* 16550 transmit FIFO depth */
+
+/* Register offsets from the port base */
+#define UART_DATA    0
+#define UART_IER     1
+#define UART_IIR     2
+#define UART_FCR     2
+#define UART_LCR     3
+#define UART_MCR     4
+#define UART_LSR     5
+#define UART_MSR     6
+#define UART_SCRATCH 7
+
+#define IER_RX_AVAILABLE  0x01
+#define IER_TX_EMPTY      0x02
+
+#define IIR_NO_PENDING    0x01
+#define IIR_ID_MASK       0x0E
+#define IIR_MODEM_STATUS  0x00
+#define IIR_TX_EMPTY      0x02
+#define IIR_RX_AVAILABLE  0x04
+#define IIR_LINE_STATUS   0x06
+#define IIR_RX_TIMEOUT    0x0C
+
+#define LSR_DATA_READY    0x01
+#define LSR_TX_EMPTY      0x20
+
+/* One 16550 instance with its transmit and receive rings */
+typedef struct {
+    uint16_t base;                      /* I/O port base address */
+    uint8_t irq;                        /* Shared: COM1/COM3 on 4, COM2/COM4 on 3 */
+    uint8_t present;                    /* Initialised by serial_port_init() */
+    uint8_t irq_mode;                   /* Polled until interrupts are enabled */
+    uint8_t raw;                        /* No LF -> CR/LF translation */
+    uint32_t baud;
+
+    /* Transmit ring, filled by writers and drained by the THR-empty IRQ */
+    volatile uint32_t tx_head;          /* Next slot to write */
+    volatile uint32_t tx_tail;          /* Next byte to send */
+    volatile int tx_active;             /* THR-empty interrupt armed */
+    volatile char tx_buffer[SERIAL_TX_BUFFER_SIZE];
+
+    /* Receive ring, filled by the RX IRQ and drained by serial_port_getc() */
+    volatile uint32_t rx_head;
+    volatile uint32_t rx_tail;
+    volatile uint32_t rx_dropped;       /* Bytes lost to a full ring */
+    volatile char rx_buffer[SERIAL_RX_BUFFER_SIZE];
+} uart_t;
+
+static const uint16_t uart_bases[SERIAL_PORTS] = { 0x3F8, 0x2F8, 0x3E8, 0x2E8 };
+static const uint8_t uart_irqs[SERIAL_PORTS] = { IRQ_COM1, IRQ_COM2, IRQ_COM1, IRQ_COM2 };
+
+static uart_t uarts[SERIAL_PORTS];
+static int interrupts_on = 0;           /* serial_enable_interrupts() was called */
+
+/* Optional replacement for console output (e.g. framing by serialmux) */
+static serial_output_t console_output = NULL;
+/* Optional second destination for console output (e.g. the VGA screen) */
+static serial_output_t console_mirror = NULL;
 
 /*
 You can find more information here: https://caro.su/msx/ocm_de1/16550.pdf
@@ -19,72 +84,442 @@ serial_getc() reads from COM1
     ↓
 Your OS receives the character
 
-If you want real keyboard input, you'd need to add a keyboard driver.
+Real keyboard input comes from the PS/2 driver in keyboard.c; console.c
+merges both sources for the shell.
 */
 
+static uart_t *uart_get(int port) {
+    if (port < 0 || port >= SERIAL_PORTS || !uarts[port].present)
+        return NULL;
+    return &uarts[port];
+}
+
+static void uart_start_interrupts(uart_t *u) {
+    u->irq_mode = 1;
+    outb(u->base + UART_IER, IER_RX_AVAILABLE);
+}
+
+/* Event source readiness: received bytes are waiting (or the UART has one) */
+int serial_port_rx_available(int port) {
+    uart_t *u = &uarts[port];
+    if (!u->irq_mode)
+        return (inb(u->base + UART_LSR) & LSR_DATA_READY) != 0;
+    return u->rx_head != u->rx_tail;
+}
+
+/*
+ * Program a port for 8N1 at 'baud', which must divide 115200. Returns -1
+ * if the baud rate is unsupported or no UART answers at the port address
+ * (checked through the scratch register).
+ */
+int serial_port_init(int port, uint32_t baud, int flags) {
+    if (port < 0 || port >= SERIAL_PORTS)
+        return -1;
+    if (baud == 0 || baud > SERIAL_MAX_BAUD || UART_CLOCK_BAUD % baud != 0)
+        return -1;
+
+    uart_t *u = &uarts[port];
+    uint16_t base = uart_bases[port];
+    uint16_t divisor = UART_CLOCK_BAUD / baud;
+
+    outb(base + UART_SCRATCH, 0xA5);
+    if (inb(base + UART_SCRATCH) != 0xA5)
+        return -1;
+
+    outb(base + UART_IER, 0x00);            /* Disable interrupts */
+    outb(base + UART_LCR, 0x80);            /* Enable DLAB (set baud rate divisor) */
+    outb(base + UART_DATA, divisor & 0xFF); /* Divisor low byte */
+    outb(base + UART_IER, divisor >> 8);    /* Divisor high byte */
+    outb(base + UART_LCR, 0x03);            /* 8 bits, no parity, 1 stop bit */
+    outb(base + UART_FCR, 0xC7);            /* Enable FIFO, clear, 14-byte threshold */
+    outb(base + UART_MCR, 0x0B);            /* IRQs enabled, RTS/DSR set */
+
+    u->base = base;
+    u->irq = uart_irqs[port];
+    u->baud = baud;
+    u->raw = (flags & SERIAL_RAW) != 0;
+    u->tx_head = u->tx_tail = 0;
+    u->tx_active = 0;
+    u->rx_head = u->rx_tail = 0;
+    u->rx_dropped = 0;
+    u->irq_mode = 0;
+    u->present = 1;
+    event_register_source(EVENT_SERIAL_RX + port, serial_port_rx_available, port);
+
+    if (interrupts_on) {
+        uint32_t irq_flags = irq_save();
+        uart_start_interrupts(u);
+        irq_enable(u->irq);
+        irq_restore(irq_flags);
+    }
+    return 0;
+}
+
+void serial_port_set_raw(int port, int raw) {
+    uart_t *u = uart_get(port);
+    if (u) u->raw = raw != 0;
+}
+
+int serial_port_present(int port) {
+    return uart_get(port) != NULL;
+}
+
+uint32_t serial_port_baud(int port) {
+    uart_t *u = uart_get(port);
+    return u ? u->baud : 0;
+}
+
 void serial_init(void) {
-    outb(COM1 + 1, 0x00);    /* Disable interrupts */
-    outb(COM1 + 3, 0x80);    /* Enable DLAB (set baud rate divisor) */
-    outb(COM1 + 0, 0x03);    /* Divisor low byte (38400 baud) */
-    outb(COM1 + 1, 0x00);    /* Divisor high byte */
-    outb(COM1 + 3, 0x03);    /* 8 bits, no parity, 1 stop bit */
-    outb(COM1 + 2, 0xC7);    /* Enable FIFO, clear, 14-byte threshold */
-    outb(COM1 + 4, 0x0B);    /* IRQs enabled, RTS/DSR set */
+    serial_port_init(SERIAL_CONSOLE, SERIAL_CONSOLE_BAUD, 0);
 }
 
-static int is_transmit_empty(void) {
-    return inb(COM1 + 5) & 0x20;
+static int is_transmit_empty(uart_t *u) {
+    return inb(u->base + UART_LSR) & LSR_TX_EMPTY;
 }
 
-void serial_putc(char c) {
-    if (c == '\n') {
-        serial_putc('\r');  /* Add carriage return */
+static uint32_t tx_count(uart_t *u) {
+    return u->tx_head - u->tx_tail;
+}
+
+/* Move up to one FIFO's worth of queued bytes into the UART */
+static void tx_fill_fifo(uart_t *u) {
+    for (int i = 0; i < UART_FIFO_SIZE && u->tx_tail != u->tx_head; i++) {
+        outb(u->base + UART_DATA, u->tx_buffer[u->tx_tail % SERIAL_TX_BUFFER_SIZE]);
+        u->tx_tail++;
     }
-    while (!is_transmit_empty());
-    outb(COM1, c);
 }
 
-void serial_puts(const char* str) {
-    while (*str) {
-        serial_putc(*str++);
+/* Drain the ring by polling; used when we cannot wait for the IRQ */
+static void tx_drain_polled(uart_t *u) {
+    while (u->tx_tail != u->tx_head) {
+        while (!is_transmit_empty(u));
+        tx_fill_fifo(u);
     }
 }
 
-static int serial_received(void) {
-    return inb(COM1 + 5) & 0x01;
+/* Arm the THR-empty interrupt; with the THR empty it fires immediately */
+static void tx_start(uart_t *u) {
+    if (!u->tx_active) {
+        u->tx_active = 1;
+        outb(u->base + UART_IER, inb(u->base + UART_IER) | IER_TX_EMPTY);
+    }
 }
 
-char serial_getc(void) {
-    while (!serial_received());
-    return inb(COM1);
+/* Queue one byte. Interrupts are off; flags are the caller's saved EFLAGS */
+static void tx_put_locked(uart_t *u, char c, uint32_t flags) {
+    while (tx_count(u) == SERIAL_TX_BUFFER_SIZE) {
+        if (!(flags & EFLAGS_IF)) {
+            /* Caller runs with interrupts off (e.g. an IRQ handler) */
+            tx_drain_polled(u);
+            break;
+        }
+        tx_start(u);
+        cpu_idle();                 /* Block until the IRQ frees space */
+        interrupts_disable();
+    }
+
+    u->tx_buffer[u->tx_head % SERIAL_TX_BUFFER_SIZE] = c;
+    u->tx_head++;
 }
 
-void serial_put_uint(uint32_t n) {
-    char buf[12];  /* Max 10 digits + sign + null */
-    int i = 0;
-    
-    if (n == 0) {
-        serial_putc('0');
+/* Polled path: one THR-empty wait per 16-byte FIFO burst */
+static void tx_write_polled(uart_t *u, const char* buf, size_t len) {
+    size_t i = 0;
+    int cr_sent = 0;
+
+    while (i < len) {
+        while (!is_transmit_empty(u));
+        for (int n = 0; n < UART_FIFO_SIZE && i < len; n++) {
+            if (buf[i] == '\n' && !u->raw && !cr_sent) {
+                outb(u->base + UART_DATA, '\r');
+                cr_sent = 1;
+                continue;
+            }
+            outb(u->base + UART_DATA, buf[i++]);
+            cr_sent = 0;
+        }
+    }
+}
+
+/*
+ * Write len bytes as one unit. The ring is first waited on until it has
+ * room for all of them (other processes may run meanwhile), then they
+ * are queued with interrupts off, so writes from different processes
+ * never interleave. Writes larger than the ring, or made with
+ * interrupts off, are queued as space allows. Text ports translate LF
+ * to CR/LF; ports opened with SERIAL_RAW pass binary data through
+ * untouched.
+ */
+void serial_port_write(int port, const char* buf, size_t len) {
+    uart_t *u = uart_get(port);
+    if (!u) return;
+
+    if (!u->irq_mode) {
+        tx_write_polled(u, buf, len);
         return;
     }
-    
-    /* Convert to string (reverse order) */
-    while (n > 0) {
-        buf[i++] = '0' + (n % 10);
-        n /= 10;
+
+    uint32_t flags = irq_save();
+    if (flags & EFLAGS_IF) {
+        uint32_t need = len;
+        for (size_t i = 0; i < len && !u->raw; i++)
+            need += buf[i] == '\n';
+        while (need <= SERIAL_TX_BUFFER_SIZE &&
+               SERIAL_TX_BUFFER_SIZE - tx_count(u) < need) {
+            tx_start(u);
+            cpu_idle();             /* Block until the IRQ frees space */
+            interrupts_disable();
+        }
+    }
+    for (size_t i = 0; i < len; i++) {
+        if (buf[i] == '\n' && !u->raw)
+            tx_put_locked(u, '\r', flags);
+        tx_put_locked(u, buf[i], flags);
+    }
+    tx_start(u);
+    irq_restore(flags);
+}
+
+/* Bytes that can be queued without blocking */
+uint32_t serial_port_tx_space(int port) {
+    uart_t *u = uart_get(port);
+    if (!u)
+        return 0;
+    if (!u->irq_mode)
+        return SERIAL_TX_BUFFER_SIZE;   /* Polled writes never queue */
+    return SERIAL_TX_BUFFER_SIZE - tx_count(u);
+}
+
+/* Wait until every queued byte has been handed to the UART */
+void serial_port_flush(int port) {
+    uart_t *u = uart_get(port);
+    if (!u || !u->irq_mode) return;
+
+    uint32_t flags = irq_save();
+    if (!(flags & EFLAGS_IF)) {
+        tx_drain_polled(u);
+    } else {
+        while (u->tx_tail != u->tx_head) {
+            cpu_idle();
+            interrupts_disable();
+        }
+    }
+    irq_restore(flags);
+}
+
+/* THR-empty: refill the FIFO in one burst, or disarm once the ring is empty */
+static void tx_interrupt(uart_t *u) {
+    if (u->tx_tail == u->tx_head) {
+        outb(u->base + UART_IER, inb(u->base + UART_IER) & ~IER_TX_EMPTY);
+        u->tx_active = 0;
+        return;
+    }
+    tx_fill_fifo(u);
+}
+
+/* RX data or FIFO timeout: empty the UART FIFO into the ring */
+static void rx_interrupt(uart_t *u, int port) {
+    int received = 0;
+
+    while (inb(u->base + UART_LSR) & LSR_DATA_READY) {
+        char c = inb(u->base + UART_DATA);
+        if (u->rx_head - u->rx_tail < SERIAL_RX_BUFFER_SIZE) {
+            u->rx_buffer[u->rx_head % SERIAL_RX_BUFFER_SIZE] = c;
+            u->rx_head++;
+            received = 1;
+        } else {
+            u->rx_dropped++;
+        }
+    }
+
+    if (received) {
+        process_wakeup_event(EVENT_SERIAL_RX + port);
+        if (port == SERIAL_CONSOLE)
+            process_wakeup_event(EVENT_CONSOLE_INPUT);
+    }
+}
+
+/* Service every port on the interrupting line until none has work pending */
+static void serial_irq_handler(interrupt_frame_t *frame) {
+    int irq = frame->vector - IRQ_BASE;
+
+    for (int port = 0; port < SERIAL_PORTS; port++) {
+        uart_t *u = &uarts[port];
+        if (!u->present || !u->irq_mode || u->irq != irq)
+            continue;
+
+        for (;;) {
+            uint8_t iir = inb(u->base + UART_IIR);
+            if (iir & IIR_NO_PENDING)
+                break;
+
+            switch (iir & IIR_ID_MASK) {
+                case IIR_TX_EMPTY:     tx_interrupt(u);             break;
+                case IIR_RX_AVAILABLE:
+                case IIR_RX_TIMEOUT:   rx_interrupt(u, port);       break;
+                case IIR_LINE_STATUS:  inb(u->base + UART_LSR);     break;
+                default:               inb(u->base + UART_MSR);     break;
+            }
+        }
     }
-    
-    /* Print in correct order */
-    while (i > 0) {
-        serial_putc(buf[--i]);
+}
+
+/* Switch transmit and receive from polling to the interrupt-driven rings */
+void serial_enable_interrupts(void) {
+    irq_install_handler(IRQ_COM1, serial_irq_handler);
+    irq_install_handler(IRQ_COM2, serial_irq_handler);
+    interrupts_on = 1;
+
+    for (int port = 0; port < SERIAL_PORTS; port++) {
+        uart_t *u = &uarts[port];
+        if (!u->present)
+            continue;
+        uart_start_interrupts(u);
+        irq_enable(u->irq);
     }
 }
 
+/* COM2 is optional: no UART there is not a boot failure */
+static int serial_trace_init(void) {
+    if (serial_port_init(SERIAL_TRACE, SERIAL_TRACE_BAUD, SERIAL_RAW) == 0)
+        klog(KLOG_INFO, "Trace channel on COM2 at %u baud", SERIAL_TRACE_BAUD);
+    return 0;
+}
+INITCALL("trace_port", serial_trace_init, INIT_LEVEL_DEVICE, "interrupt");
+
+static int serial_irq_init(void) {
+    serial_enable_interrupts();
+    return 0;
+}
+INITCALL("serial_irq", serial_irq_init, INIT_LEVEL_DEVICE, "interrupt trace_port");
+
+static int serial_received(uart_t *u) {
+    return inb(u->base + UART_LSR) & LSR_DATA_READY;
+}
+
+/*
+ * Block until a byte arrives. A process with its own stack is put into
+ * PR_WAIT on EVENT_SERIAL_RX + port so others can run; code on the boot
+ * stack (the shell in kmain) halts the CPU until the next interrupt.
+ */
+char serial_port_getc(int port) {
+    uart_t *u = uart_get(port);
+    if (!u) return 0;
+
+    if (!u->irq_mode) {
+        while (!serial_received(u));
+        return inb(u->base + UART_DATA);
+    }
+
+    uint32_t flags = irq_save();
+    while (u->rx_head == u->rx_tail) {
+        if (process_can_block()) {
+            process_wait_event(EVENT_SERIAL_RX + port);
+        } else {
+            process_idle_wait();
+        }
+    }
+    char c = u->rx_buffer[u->rx_tail % SERIAL_RX_BUFFER_SIZE];
+    u->rx_tail++;
+    irq_restore(flags);
+    return c;
+}
+
+/* Next received byte, or -1 if none is buffered */
+int serial_port_try_getc(int port) {
+    uart_t *u = uart_get(port);
+    if (!u) return -1;
+
+    if (!u->irq_mode)
+        return serial_received(u) ? inb(u->base + UART_DATA) : -1;
+
+    uint32_t flags = irq_save();
+    int c = -1;
+    if (u->rx_head != u->rx_tail) {
+        c = (unsigned char)u->rx_buffer[u->rx_tail % SERIAL_RX_BUFFER_SIZE];
+        u->rx_tail++;
+    }
+    irq_restore(flags);
+    return c;
+}
+
+uint32_t serial_port_rx_dropped(int port) {
+    uart_t *u = uart_get(port);
+    return u ? u->rx_dropped : 0;
+}
+
+/* -------------------------------------------------- */
+/* Console (COM1) helpers                             */
+/* -------------------------------------------------- */
+
+/* Route console output through 'output' instead of COM1; NULL restores it */
+void serial_set_console_output(serial_output_t output) {
+    console_output = output;
+}
+
+/* Also copy console output to 'mirror'; NULL stops mirroring. Returns
+ * the previous mirror so a caller can restore it */
+serial_output_t serial_set_console_mirror(serial_output_t mirror) {
+    serial_output_t previous = console_mirror;
+
+    console_mirror = mirror;
+    return previous;
+}
+
+void serial_write(const char* buf, size_t len) {
+    if (console_output)
+        console_output(buf, len);
+    else
+        serial_port_write(SERIAL_CONSOLE, buf, len);
+    if (console_mirror)
+        console_mirror(buf, len);
+}
+
+void serial_putc(char c) {
+    serial_write(&c, 1);
+}
+
+void serial_puts(const char* str) {
+    serial_write(str, strlen(str));
+}
+
+char serial_getc(void) {
+    return serial_port_getc(SERIAL_CONSOLE);
+}
+
+void serial_flush(void) {
+    serial_port_flush(SERIAL_CONSOLE);
+}
+
+uint32_t serial_tx_space(void) {
+    return serial_port_tx_space(SERIAL_CONSOLE);
+}
+
+uint32_t serial_rx_dropped(void) {
+    return serial_port_rx_dropped(SERIAL_CONSOLE);
+}
+
+void serial_put_uint(uint32_t n) {
+    char buf[10];  /* Max 10 digits */
+    int i = sizeof(buf);
+
+    /* Convert to string, filling from the end */
+    do {
+        buf[--i] = '0' + (n % 10);
+        n /= 10;
+    } while (n > 0);
+
+    serial_write(buf + i, sizeof(buf) - i);
+}
+
 void serial_put_hex(uint32_t n) {
     const char hex[] = "0123456789ABCDEF";
-    serial_puts("0x");
-    
-    for (int i = 7; i >= 0; i--) {
-        serial_putc(hex[(n >> (i * 4)) & 0xF]);
+    char buf[10];
+
+    buf[0] = '0';
+    buf[1] = 'x';
+    for (int i = 0; i < 8; i++) {
+        buf[2 + i] = hex[(n >> ((7 - i) * 4)) & 0xF];
     }
+    serial_write(buf, sizeof(buf));
 }
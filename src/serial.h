@@ -4,11 +4,56 @@
 
 #include "types.h"
 
+/* Transmit ring size in bytes (power of two) */
+#define SERIAL_TX_BUFFER_SIZE 1024
+/* Receive ring size in bytes (power of two) */
+#define SERIAL_RX_BUFFER_SIZE 256
+
+/* Port numbers */
+#define SERIAL_COM1   0
+#define SERIAL_COM2   1
+#define SERIAL_COM3   2
+#define SERIAL_COM4   3
+#define SERIAL_PORTS  4
+
+/* Interactive console, and the binary trace/benchmark channel */
+#define SERIAL_CONSOLE       SERIAL_COM1
+#define SERIAL_TRACE         SERIAL_COM2
+#define SERIAL_CONSOLE_BAUD  38400
+#define SERIAL_TRACE_BAUD    115200
+#define SERIAL_MAX_BAUD      115200
+
+/* serial_port_init() flags */
+#define SERIAL_RAW    0x01   /* Binary data: no LF -> CR/LF translation */
+
+typedef void (*serial_output_t)(const char* buf, size_t len);
+
+/* Per-port interface */
+int serial_port_init(int port, uint32_t baud, int flags);
+int serial_port_present(int port);
+void serial_port_set_raw(int port, int raw);
+uint32_t serial_port_baud(int port);
+void serial_port_write(int port, const char* buf, size_t len);
+char serial_port_getc(int port);
+int serial_port_try_getc(int port);
+int serial_port_rx_available(int port);
+void serial_port_flush(int port);
+uint32_t serial_port_tx_space(int port);
+uint32_t serial_port_rx_dropped(int port);
+
+/* Console (COM1) interface */
 void serial_init(void);
+void serial_enable_interrupts(void);
+void serial_set_console_output(serial_output_t output);
+serial_output_t serial_set_console_mirror(serial_output_t mirror);
+void serial_flush(void);
+uint32_t serial_tx_space(void);
 void serial_putc(char c);
+void serial_write(const char* buf, size_t len);
 void serial_puts(const char* str);
 char serial_getc(void);
+uint32_t serial_rx_dropped(void);
 void serial_put_uint(uint32_t n);
 void serial_put_hex(uint32_t n);
 
-#endif
\ No newline at end of file
+#endif
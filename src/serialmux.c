@@ -0,0 +1,206 @@
+/* serialmux.c - Framed multiplexing of console, log and binary channels */
+#include "serialmux.h"
+#include "serial.h"
+#include "kprintf.h"
+#include "klog.h"
+#include "string.h"
+#include "timer.h"
+#include "cpu.h"
+#include "shell.h"
+
+#define MUX_TEST_RECORDS  1024
+
+static const uint16_t crc16_table[256] = {
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+    0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF,
+    0x1231, 0x0210, 0x3273, 0x2252, 0x52B5, 0x4294, 0x72F7, 0x62D6,
+    0x9339, 0x8318, 0xB37B, 0xA35A, 0xD3BD, 0xC39C, 0xF3FF, 0xE3DE,
+    0x2462, 0x3443, 0x0420, 0x1401, 0x64E6, 0x74C7, 0x44A4, 0x5485,
+    0xA56A, 0xB54B, 0x8528, 0x9509, 0xE5EE, 0xF5CF, 0xC5AC, 0xD58D,
+    0x3653, 0x2672, 0x1611, 0x0630, 0x76D7, 0x66F6, 0x5695, 0x46B4,
+    0xB75B, 0xA77A, 0x9719, 0x8738, 0xF7DF, 0xE7FE, 0xD79D, 0xC7BC,
+    0x48C4, 0x58E5, 0x6886, 0x78A7, 0x0840, 0x1861, 0x2802, 0x3823,
+    0xC9CC, 0xD9ED, 0xE98E, 0xF9AF, 0x8948, 0x9969, 0xA90A, 0xB92B,
+    0x5AF5, 0x4AD4, 0x7AB7, 0x6A96, 0x1A71, 0x0A50, 0x3A33, 0x2A12,
+    0xDBFD, 0xCBDC, 0xFBBF, 0xEB9E, 0x9B79, 0x8B58, 0xBB3B, 0xAB1A,
+    0x6CA6, 0x7C87, 0x4CE4, 0x5CC5, 0x2C22, 0x3C03, 0x0C60, 0x1C41,
+    0xEDAE, 0xFD8F, 0xCDEC, 0xDDCD, 0xAD2A, 0xBD0B, 0x8D68, 0x9D49,
+    0x7E97, 0x6EB6, 0x5ED5, 0x4EF4, 0x3E13, 0x2E32, 0x1E51, 0x0E70,
+    0xFF9F, 0xEFBE, 0xDFDD, 0xCFFC, 0xBF1B, 0xAF3A, 0x9F59, 0x8F78,
+    0x9188, 0x81A9, 0xB1CA, 0xA1EB, 0xD10C, 0xC12D, 0xF14E, 0xE16F,
+    0x1080, 0x00A1, 0x30C2, 0x20E3, 0x5004, 0x4025, 0x7046, 0x6067,
+    0x83B9, 0x9398, 0xA3FB, 0xB3DA, 0xC33D, 0xD31C, 0xE37F, 0xF35E,
+    0x02B1, 0x1290, 0x22F3, 0x32D2, 0x4235, 0x5214, 0x6277, 0x7256,
+    0xB5EA, 0xA5CB, 0x95A8, 0x8589, 0xF56E, 0xE54F, 0xD52C, 0xC50D,
+    0x34E2, 0x24C3, 0x14A0, 0x0481, 0x7466, 0x6447, 0x5424, 0x4405,
+    0xA7DB, 0xB7FA, 0x8799, 0x97B8, 0xE75F, 0xF77E, 0xC71D, 0xD73C,
+    0x26D3, 0x36F2, 0x0691, 0x16B0, 0x6657, 0x7676, 0x4615, 0x5634,
+    0xD94C, 0xC96D, 0xF90E, 0xE92F, 0x99C8, 0x89E9, 0xB98A, 0xA9AB,
+    0x5844, 0x4865, 0x7806, 0x6827, 0x18C0, 0x08E1, 0x3882, 0x28A3,
+    0xCB7D, 0xDB5C, 0xEB3F, 0xFB1E, 0x8BF9, 0x9BD8, 0xABBB, 0xBB9A,
+    0x4A75, 0x5A54, 0x6A37, 0x7A16, 0x0AF1, 0x1AD0, 0x2AB3, 0x3A92,
+    0xFD2E, 0xED0F, 0xDD6C, 0xCD4D, 0xBDAA, 0xAD8B, 0x9DE8, 0x8DC9,
+    0x7C26, 0x6C07, 0x5C64, 0x4C45, 0x3CA2, 0x2C83, 0x1CE0, 0x0CC1,
+    0xEF1F, 0xFF3E, 0xCF5D, 0xDF7C, 0xAF9B, 0xBFBA, 0x8FD9, 0x9FF8,
+    0x6E17, 0x7E36, 0x4E55, 0x5E74, 0x2E93, 0x3EB2, 0x0ED1, 0x1EF0
+};
+
+static int mux_port = -1;           /* Port carrying frames, or -1 */
+static uint32_t frames_sent = 0;
+static uint32_t bytes_sent = 0;     /* Payload bytes */
+
+/* CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF), one table lookup per byte */
+uint16_t serialmux_crc16(uint16_t crc, const uint8_t *data, size_t len) {
+    while (len--) {
+        crc = (crc << 8) ^ crc16_table[((crc >> 8) ^ *data++) & 0xFF];
+    }
+    return crc;
+}
+
+/* Console hook: shell output becomes channel 0 frames */
+static void serialmux_console_write(const char *buf, size_t len) {
+    serialmux_send(MUX_CH_CONSOLE, buf, len);
+}
+
+/* Kernel log hooks: flushed records become channel 1 frames */
+static void serialmux_log_write(const char *buf, size_t len) {
+    serialmux_send(MUX_CH_LOG, buf, len);
+}
+
+static uint32_t serialmux_log_space(void) {
+    return serial_port_tx_space(mux_port);
+}
+
+/*
+ * Start framing output on 'port'. The port is switched to raw mode so
+ * frame bytes are not altered; if it is the console port, console output
+ * is wrapped into MUX_CH_CONSOLE frames. Kernel log records go to
+ * MUX_CH_LOG on either port. Input stays unframed.
+ */
+int serialmux_attach(int port) {
+    if (!serial_port_present(port))
+        return -1;
+
+    serialmux_detach();
+    klog_flush();
+    serial_port_set_raw(port, 1);
+    mux_port = port;
+    if (port == SERIAL_CONSOLE)
+        serial_set_console_output(serialmux_console_write);
+    klog_set_output(serialmux_log_write, serialmux_log_space);
+    return 0;
+}
+
+void serialmux_detach(void) {
+    if (mux_port < 0)
+        return;
+
+    klog_flush();
+    klog_set_output(NULL, NULL);
+    if (mux_port == SERIAL_CONSOLE) {
+        serial_set_console_output(NULL);
+        serial_port_set_raw(mux_port, 0);
+    }
+    mux_port = -1;
+}
+
+int serialmux_active(void) {
+    return mux_port >= 0;
+}
+
+/*
+ * Send 'len' bytes on 'channel'. Each frame is assembled in one buffer
+ * and handed to serial_port_write() in a single call, so frames from
+ * different senders never interleave on the wire.
+ */
+int serialmux_send(int channel, const void *data, size_t len) {
+    const uint8_t *p = (const uint8_t *)data;
+    uint8_t frame[SERIALMUX_HEADER_SIZE + SERIALMUX_MAX_PAYLOAD + 2];
+
+    if (mux_port < 0)
+        return -1;
+
+    do {
+        size_t chunk = len < SERIALMUX_MAX_PAYLOAD ? len : SERIALMUX_MAX_PAYLOAD;
+
+        frame[0] = SERIALMUX_SYNC0;
+        frame[1] = SERIALMUX_SYNC1;
+        frame[2] = (uint8_t)channel;
+        frame[3] = chunk & 0xFF;
+        frame[4] = (chunk >> 8) & 0xFF;
+        for (size_t i = 0; i < chunk; i++) {
+            frame[SERIALMUX_HEADER_SIZE + i] = p[i];
+        }
+
+        uint16_t crc = serialmux_crc16(0xFFFF, frame + 2, 3 + chunk);
+        frame[SERIALMUX_HEADER_SIZE + chunk] = crc & 0xFF;
+        frame[SERIALMUX_HEADER_SIZE + chunk + 1] = crc >> 8;
+
+        serial_port_write(mux_port, (const char *)frame,
+                          SERIALMUX_HEADER_SIZE + chunk + 2);
+        frames_sent++;
+        bytes_sent += chunk;
+
+        p += chunk;
+        len -= chunk;
+    } while (len > 0);
+
+    return 0;
+}
+
+void serialmux_stats(void) {
+    if (mux_port < 0) {
+        kprintf("serialmux: inactive\n");
+        return;
+    }
+    kprintf("serialmux: COM%d, %u frames, %u payload bytes\n",
+            mux_port + 1, frames_sent, bytes_sent);
+}
+
+/* Stream binary metric records over the mux at full line rate */
+static void serialmux_test(void) {
+    struct {
+        uint32_t seq;
+        uint64_t tsc;
+    } __attribute__((packed)) record;
+
+    if (!serialmux_active()) {
+        serial_puts("serialmux is not attached; use 'mux on' or 'mux trace'\n");
+        return;
+    }
+
+    uint64_t start = rdtsc();
+    for (uint32_t i = 0; i < MUX_TEST_RECORDS; i++) {
+        record.seq = i;
+        record.tsc = rdtsc();
+        serialmux_send(MUX_CH_METRICS, &record, sizeof(record));
+    }
+    uint32_t us = timer_cycles_to_us(rdtsc() - start);
+    if (us == 0)
+        us = 1;
+    kprintf("mux metrics: %u bytes/sec (%u us)\n",
+            (uint32_t)div64_u32((uint64_t)MUX_TEST_RECORDS * sizeof(record) * 1000000, us), us);
+}
+
+static int mux_command(int argc, char **argv) {
+    if (argc > 2)
+        return SHELL_USAGE;
+    if (argc == 2) {
+        if (strcmp(argv[1], "on") == 0) {
+            serialmux_attach(SERIAL_CONSOLE);
+        } else if (strcmp(argv[1], "trace") == 0) {
+            if (serialmux_attach(SERIAL_TRACE) != 0)
+                serial_puts("COM2 is not present\n");
+        } else if (strcmp(argv[1], "off") == 0) {
+            serialmux_detach();
+        } else if (strcmp(argv[1], "test") == 0) {
+            serialmux_test();
+            return SHELL_OK;
+        } else {
+            return SHELL_USAGE;
+        }
+    }
+    serialmux_stats();
+    return SHELL_OK;
+}
+SHELL_COMMAND("mux", mux_command, "[on|trace|off|test]", "Framed serial mux (see tools/muxdemux.py)");
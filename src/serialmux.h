@@ -0,0 +1,33 @@
+/* serialmux.h - Framed multiplexing protocol over a serial port */
+#ifndef SERIALMUX_H
+#define SERIALMUX_H
+
+#include "types.h"
+
+/*
+ * Frame layout (all fields little-endian):
+ *
+ *   0xA5 0x5A | channel:u8 | length:u16 | payload[length] | crc:u16
+ *
+ * The CRC is CRC-16/CCITT-FALSE over channel, length and payload. A
+ * receiver that loses sync scans for the next 0xA5 0x5A and accepts a
+ * frame only if its CRC matches. tools/muxdemux.py is the host side.
+ */
+#define SERIALMUX_SYNC0        0xA5
+#define SERIALMUX_SYNC1        0x5A
+#define SERIALMUX_HEADER_SIZE  5
+#define SERIALMUX_MAX_PAYLOAD  256   /* Larger sends are split into frames */
+
+/* Channel assignments */
+#define MUX_CH_CONSOLE   0   /* Shell output text */
+#define MUX_CH_LOG       1   /* Kernel log text */
+#define MUX_CH_METRICS   2   /* Binary metric records */
+
+int serialmux_attach(int port);
+void serialmux_detach(void);
+int serialmux_active(void);
+int serialmux_send(int channel, const void *data, size_t len);
+uint16_t serialmux_crc16(uint16_t crc, const uint8_t *data, size_t len);
+void serialmux_stats(void);
+
+#endif
@@ -0,0 +1,208 @@
+/* shell.c - Shell command registry and dispatch */
+#include "shell.h"
+#include "string.h"
+#include "kprintf.h"
+#include "klog.h"
+#include "initcall.h"
+#include "process.h"
+#include "interrupt.h"
+
+/* Bounds of the SHELL_COMMAND() pointer table */
+extern const shell_command_t *const __start_shell_commands[];
+extern const shell_command_t *const __stop_shell_commands[];
+
+/* Background jobs ("cmd args &"), indexed by pid: a slot is only reused
+ * once its process has exited */
+typedef struct {
+    const shell_command_t *cmd;
+    int argc;
+    char *argv[SHELL_MAX_ARGS + 1];
+    char line[SHELL_LINE_MAX];
+} shell_job_t;
+
+static shell_job_t jobs[MAX_PROCS];
+
+/* Open-addressed hash of the names, and the same commands sorted for help */
+static const shell_command_t *slots[SHELL_HASH_SLOTS];
+static const shell_command_t *sorted[SHELL_MAX_COMMANDS];
+static int count;
+
+/* FNV-1a over the name */
+static uint32_t shell_hash(const char *name) {
+    uint32_t h = 2166136261u;
+
+    while (*name) {
+        h ^= (uint8_t)*name++;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+const shell_command_t *shell_find(const char *name) {
+    uint32_t i = shell_hash(name);
+
+    for (int probe = 0; probe < SHELL_HASH_SLOTS; probe++, i++) {
+        const shell_command_t *cmd = slots[i & (SHELL_HASH_SLOTS - 1)];
+        if (!cmd)
+            return NULL;
+        if (strcmp(cmd->name, name) == 0)
+            return cmd;
+    }
+    return NULL;
+}
+
+/* Returns 0, or -1 if the name is taken or the table is full */
+int shell_register(const shell_command_t *cmd) {
+    uint32_t i = shell_hash(cmd->name);
+    int pos;
+
+    if (count == SHELL_MAX_COMMANDS || shell_find(cmd->name))
+        return -1;
+
+    while (slots[i & (SHELL_HASH_SLOTS - 1)])
+        i++;
+    slots[i & (SHELL_HASH_SLOTS - 1)] = cmd;
+
+    for (pos = count; pos > 0 && strcmp(sorted[pos - 1]->name, cmd->name) > 0; pos--)
+        sorted[pos] = sorted[pos - 1];
+    sorted[pos] = cmd;
+    count++;
+    return 0;
+}
+
+/*
+ * Split line in place at spaces into at most max words. Returns the
+ * word count, or -1 if there are more than max.
+ */
+int shell_split(char *line, char **argv, int max) {
+    int argc = 0;
+
+    for (;;) {
+        while (*line == ' ')
+            *line++ = '\0';
+        if (!*line)
+            return argc;
+        if (argc == max)
+            return -1;
+        argv[argc++] = line;
+        while (*line && *line != ' ')
+            line++;
+    }
+}
+
+static void shell_usage(const shell_command_t *cmd) {
+    kprintf("Usage: %s%s%s\n", cmd->name, cmd->usage ? " " : "",
+            cmd->usage ? cmd->usage : "");
+}
+
+static void shell_job(void) {
+    shell_job_t *job = &jobs[currpid->pid];
+    int result = job->cmd->fn(job->argc, job->argv);
+
+    if (result == SHELL_USAGE)
+        shell_usage(job->cmd);
+    kprintf("[%d] done  %s\n", currpid->pid, job->cmd->name);
+}
+
+/* Copy the arguments and run the command in a process of its own */
+static int shell_background(const shell_command_t *cmd, int argc, char **argv) {
+    const process_attr_t attr = { cmd->name, PRIO_DEFAULT, SHELL_STACK_SIZE, 0 };
+    uint32_t flags = irq_save();    /* The job must not start before it is filled in */
+    int32_t pid = process_spawn(&attr, shell_job, NULL);
+
+    if (pid >= 0) {
+        shell_job_t *job = &jobs[pid];
+        char *p = job->line;
+
+        job->cmd = cmd;
+        job->argc = argc;
+        for (int i = 0; i < argc; i++) {
+            size_t len = strlen(argv[i]) + 1;
+            memcpy(p, argv[i], len);
+            job->argv[i] = p;
+            p += len;
+        }
+        job->argv[argc] = NULL;
+    }
+    irq_restore(flags);
+
+    if (pid < 0) {
+        kprintf("No free process slot for '%s'\n", cmd->name);
+        return -1;
+    }
+    kprintf("[%d] %s\n", pid, cmd->name);
+    return SHELL_OK;
+}
+
+/*
+ * Run one input line. Returns the handler's result, 0 for a blank line,
+ * or -1 if the line does not name a command. A trailing "&" word runs
+ * the command as a background process instead.
+ */
+int shell_execute(char *line) {
+    char *argv[SHELL_MAX_ARGS + 2];     /* Room for a trailing "&" */
+    int argc = shell_split(line, argv, SHELL_MAX_ARGS + 1);
+    const shell_command_t *cmd;
+    int background, result;
+
+    if (argc == 0)
+        return 0;
+    if (argc > 0) {
+        background = strcmp(argv[argc - 1], "&") == 0;
+        if (background && --argc == 0)
+            return 0;
+    }
+    if (argc < 0 || argc > SHELL_MAX_ARGS) {
+        kprintf("Too many arguments (at most %d)\n", SHELL_MAX_ARGS - 1);
+        return -1;
+    }
+    argv[argc] = NULL;
+
+    cmd = shell_find(argv[0]);
+    if (!cmd) {
+        kprintf("Unknown command: %s\nType 'help' for available commands.\n", argv[0]);
+        return -1;
+    }
+    if (background)
+        return shell_background(cmd, argc, argv);
+    result = cmd->fn(argc, argv);
+    if (result == SHELL_USAGE)
+        shell_usage(cmd);
+    return result;
+}
+
+void shell_help(void) {
+    kprintf("Available commands:\n");
+    for (int i = 0; i < count; i++)
+        kprintf("  %-10s - %s\n", sorted[i]->name, sorted[i]->help);
+}
+
+static int help_command(int argc, char **argv) {
+    const shell_command_t *cmd;
+
+    if (argc == 1) {
+        shell_help();
+        return SHELL_OK;
+    }
+    if (argc != 2)
+        return SHELL_USAGE;
+    cmd = shell_find(argv[1]);
+    if (!cmd) {
+        kprintf("No such command: %s\n", argv[1]);
+        return SHELL_OK;
+    }
+    shell_usage(cmd);
+    kprintf("  %s\n", cmd->help);
+    return SHELL_OK;
+}
+SHELL_COMMAND("help", help_command, "[command]", "Show this help, or one command's usage");
+
+static int shell_init(void) {
+    for (const shell_command_t *const *c = __start_shell_commands; c < __stop_shell_commands; c++) {
+        if (shell_register(*c) != 0)
+            klog(KLOG_WARN, "shell: command '%s' not registered", (*c)->name);
+    }
+    klog(KLOG_INFO, "Shell: %d commands", count);
+    return 0;
+}
+INITCALL("shell", shell_init, INIT_LEVEL_KERNEL, NULL);
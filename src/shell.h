@@ -0,0 +1,42 @@
+/* shell.h - Shell command registry and dispatch */
+#ifndef SHELL_H
+#define SHELL_H
+
+#include "types.h"
+
+#define SHELL_LINE_MAX      128
+#define SHELL_MAX_ARGS      8       /* argv entries, command name included */
+#define SHELL_MAX_COMMANDS  64
+#define SHELL_HASH_SLOTS    128     /* Power of two, at least 2x the commands */
+#define SHELL_STACK_SIZE    8192    /* Shell and background job stacks */
+
+/* Handler return values */
+#define SHELL_OK            0
+#define SHELL_USAGE         1       /* Bad arguments: the shell prints usage */
+
+typedef struct {
+    const char *name;
+    int (*fn)(int argc, char **argv);   /* argv[0] is the command name */
+    const char *usage;                  /* Arguments after the name, or NULL */
+    const char *help;                   /* One line for 'help' */
+} shell_command_t;
+
+/*
+ * Register a command at link time, next to the code it controls:
+ *   SHELL_COMMAND("mem", mem_command, NULL, "Show memory statistics");
+ * The "shell" initcall adds the whole table; shell_register() adds
+ * commands at run time. The section name is a C identifier, so GNU ld
+ * also provides its __start_/__stop_ bounds in host builds.
+ */
+#define SHELL_COMMAND(name, fn, usage, help)                                 \
+    static const shell_command_t shell_desc_##fn = { name, fn, usage, help }; \
+    static const shell_command_t *const shell_ptr_##fn                      \
+        __attribute__((section("shell_commands"), used)) = &shell_desc_##fn
+
+int shell_register(const shell_command_t *cmd);
+const shell_command_t *shell_find(const char *name);
+int shell_split(char *line, char **argv, int max);
+int shell_execute(char *line);
+void shell_help(void);
+
+#endif
@@ -1,20 +1,193 @@
 /* string.c - String utility implementations */
 #include "string.h"
+#include "cpu.h"
+#include "klog.h"
+#include "initcall.h"
+
+static size_t strlen_scalar(const char* str);
+static void* memset_scalar(void* ptr, int value, size_t num);
+static void* memcpy_scalar(void* dest, const void* src, size_t num);
+static int memcmp_scalar(const void* ptr1, const void* ptr2, size_t num);
+
+/* -------------------------------------------------- */
+/* Implementation selection                           */
+/* -------------------------------------------------- */
+
+static void* memset_sse2_sized(void* ptr, int value, size_t num) {
+    if (num < STRING_SSE2_MIN)
+        return memset_scalar(ptr, value, num);
+    return memset_sse2(ptr, value, num);
+}
+
+static void* memcpy_sse2_sized(void* dest, const void* src, size_t num) {
+    if (num < STRING_SSE2_MIN)
+        return memcpy_scalar(dest, src, num);
+    return memcpy_sse2(dest, src, num);
+}
+
+static int memcmp_sse2_sized(const void* ptr1, const void* ptr2, size_t num) {
+    if (num < 16)
+        return memcmp_scalar(ptr1, ptr2, num);
+    return memcmp_sse2(ptr1, ptr2, num);
+}
+
+static size_t (*strlen_impl)(const char*) = strlen_scalar;
+static void* (*memset_impl)(void*, int, size_t) = memset_scalar;
+static void* (*memcpy_impl)(void*, const void*, size_t) = memcpy_scalar;
+static int (*memcmp_impl)(const void*, const void*, size_t) = memcmp_scalar;
+
+/*
+ * Pick the SSE2 or scalar versions. SSE2 is only used once
+ * cpu_enable_sse() has made it available; returns whether it is in use.
+ */
+int string_use_sse2(int enable) {
+    if (enable && cpu_has(CPU_FEATURE_XMM)) {
+        strlen_impl = strlen_sse2;
+        memcmp_impl = memcmp_sse2_sized;
+        /* rep stosb/movsb outruns 16-byte moves from 1 KB up on ERMSB CPUs */
+        memset_impl = cpu_has(CPU_FEATURE_ERMSB) ? memset_scalar : memset_sse2_sized;
+        memcpy_impl = cpu_has(CPU_FEATURE_ERMSB) ? memcpy_scalar : memcpy_sse2_sized;
+        return 1;
+    }
+    strlen_impl = strlen_scalar;
+    memset_impl = memset_scalar;
+    memcpy_impl = memcpy_scalar;
+    memcmp_impl = memcmp_scalar;
+    return 0;
+}
+
+int string_sse2_active(void) {
+    return strlen_impl == strlen_sse2;
+}
+
+static int string_init(void) {
+    if (cpu_enable_sse() && string_use_sse2(1))
+        klog(KLOG_INFO, "SSE2 string and memory routines enabled");
+    return 0;
+}
+INITCALL("string", string_init, INIT_LEVEL_CPU, "cpu");
 
 size_t strlen(const char* str) {
-    size_t len = 0;
-    while (str[len]) {
-        len++;
+    return strlen_impl(str);
+}
+
+void* memset(void* ptr, int value, size_t num) {
+    return memset_impl(ptr, value, num);
+}
+
+void* memcpy(void* dest, const void* src, size_t num) {
+    return memcpy_impl(dest, src, num);
+}
+
+int memcmp(const void* ptr1, const void* ptr2, size_t num) {
+    return memcmp_impl(ptr1, ptr2, num);
+}
+
+/* -------------------------------------------------- */
+/* Scalar implementations                             */
+/* -------------------------------------------------- */
+
+/*
+ * The string routines below scan a 32-bit word per step. HAS_ZERO(w) is
+ * non-zero exactly when some byte of w is zero: subtracting 1 from each
+ * byte sets bit 7 of a zero byte, and ~w masks off bytes whose bit 7 was
+ * already set. Loads are aligned, so a scan that reads past the
+ * terminator never crosses into the next page.
+ */
+typedef uint32_t __attribute__((may_alias)) word_t;
+
+#define WORD_ONES   0x01010101u
+#define WORD_HIGHS  0x80808080u
+#define HAS_ZERO(w) (((w) - WORD_ONES) & ~(w) & WORD_HIGHS)
+
+static size_t strlen_scalar(const char* str) {
+    const char* p = str;
+
+    while ((uint32_t)p & 3) {
+        if (!*p)
+            return p - str;
+        p++;
+    }
+    while (!HAS_ZERO(*(const word_t*)p))
+        p += 4;
+    while (*p)
+        p++;
+    return p - str;
+}
+
+size_t strnlen(const char* str, size_t maxlen) {
+    const char* p = str;
+
+    while (maxlen && ((uint32_t)p & 3)) {
+        if (!*p)
+            return p - str;
+        p++;
+        maxlen--;
     }
-    return len;
+    while (maxlen >= 4 && !HAS_ZERO(*(const word_t*)p)) {
+        p += 4;
+        maxlen -= 4;
+    }
+    while (maxlen && *p) {
+        p++;
+        maxlen--;
+    }
+    return p - str;
 }
 
+/*
+ * strcmp/strncmp compare whole words when both strings share the same
+ * alignment, stopping at the first word that differs or holds the
+ * terminator; the byte loop then finds the exact position in it.
+ */
 int strcmp(const char* str1, const char* str2) {
-    while (*str1 && (*str1 == *str2)) {
-        str1++;
-        str2++;
+    const unsigned char* a = (const unsigned char*)str1;
+    const unsigned char* b = (const unsigned char*)str2;
+
+    if ((((uint32_t)a ^ (uint32_t)b) & 3) == 0) {
+        while ((uint32_t)a & 3) {
+            if (*a != *b || !*a)
+                return *a - *b;
+            a++;
+            b++;
+        }
+        while (*(const word_t*)a == *(const word_t*)b && !HAS_ZERO(*(const word_t*)a)) {
+            a += 4;
+            b += 4;
+        }
     }
-    return *(unsigned char*)str1 - *(unsigned char*)str2;
+    while (*a && *a == *b) {
+        a++;
+        b++;
+    }
+    return *a - *b;
+}
+
+int strncmp(const char* str1, const char* str2, size_t n) {
+    const unsigned char* a = (const unsigned char*)str1;
+    const unsigned char* b = (const unsigned char*)str2;
+
+    if ((((uint32_t)a ^ (uint32_t)b) & 3) == 0) {
+        while (n && ((uint32_t)a & 3)) {
+            if (*a != *b || !*a)
+                return *a - *b;
+            a++;
+            b++;
+            n--;
+        }
+        while (n >= 4 && *(const word_t*)a == *(const word_t*)b &&
+               !HAS_ZERO(*(const word_t*)a)) {
+            a += 4;
+            b += 4;
+            n -= 4;
+        }
+    }
+    while (n && *a && *a == *b) {
+        a++;
+        b++;
+        n--;
+    }
+    return n ? *a - *b : 0;
 }
 
 char* strcpy(char* dest, const char* src) {
@@ -22,21 +195,204 @@ char* strcpy(char* dest, const char* src) {
     while ((*dest++ = *src++));
     return original_dest;
 }
+
+/* Copy whole words until one holds the terminator, then pad with memset */
 char* strncpy(char* dest, const char* src, size_t n) {
-    size_t i;
-    for (i = 0; i < n && src[i] != '\0'; i++) {
+    size_t i = 0;
+
+    while (i < n && ((uint32_t)(src + i) & 3)) {
+        if (!src[i])
+            break;
         dest[i] = src[i];
+        i++;
     }
-    for (; i < n; i++) {
-        dest[i] = '\0';
+    while (n - i >= 4) {
+        uint32_t w = *(const word_t*)(src + i);
+        if (HAS_ZERO(w))
+            break;
+        *(word_t*)(dest + i) = w;
+        i += 4;
     }
+    while (i < n && src[i]) {
+        dest[i] = src[i];
+        i++;
+    }
+    memset(dest + i, 0, n - i);
     return dest;
 }
 
-void* memset(void* ptr, int value, size_t num) {
+/* XOR with the replicated byte turns matches into zero bytes for HAS_ZERO */
+void* memchr(const void* ptr, int value, size_t num) {
+    const unsigned char* p = (const unsigned char*)ptr;
+    unsigned char byte = (unsigned char)value;
+    uint32_t pattern = byte * WORD_ONES;
+
+    while (num && ((uint32_t)p & 3)) {
+        if (*p == byte)
+            return (void*)p;
+        p++;
+        num--;
+    }
+    while (num >= 4 && !HAS_ZERO(*(const word_t*)p ^ pattern)) {
+        p += 4;
+        num -= 4;
+    }
+    while (num) {
+        if (*p == byte)
+            return (void*)p;
+        p++;
+        num--;
+    }
+    return NULL;
+}
+
+/* -------------------------------------------------- */
+/* Memory block operations                            */
+/* -------------------------------------------------- */
+
+/*
+ * Blocks of at least STRING_BULK_MIN bytes use the x86 string
+ * instructions: the destination is first aligned to 4 bytes, then
+ * rep stosl/movsl moves a word per element. On CPUs with ERMSB, rep
+ * movsb/stosb is as fast as the dword forms from STRING_ERMSB_MIN bytes
+ * up and handles any alignment, so it is used there instead. Shorter
+ * blocks use word and byte loops, where the setup cost of rep would
+ * dominate.
+ */
+
+static void* memset_scalar(void* ptr, int value, size_t num) {
     unsigned char* p = (unsigned char*)ptr;
+    unsigned char byte = (unsigned char)value;
+    uint32_t pattern = byte * WORD_ONES;
+
+    if (num >= STRING_ERMSB_MIN && cpu_has(CPU_FEATURE_ERMSB)) {
+        __asm__ volatile ("rep stosb"
+                          : "+D"(p), "+c"(num)
+                          : "a"(byte)
+                          : "memory");
+        return ptr;
+    }
+
+    if (num >= STRING_BULK_MIN) {
+        while ((uint32_t)p & 3) {
+            *p++ = byte;
+            num--;
+        }
+        size_t words = num >> 2;
+        __asm__ volatile ("rep stosl"
+                          : "+D"(p), "+c"(words)
+                          : "a"(pattern)
+                          : "memory");
+        num &= 3;
+    }
+
+    while (num >= 4) {
+        *(word_t*)p = pattern;
+        p += 4;
+        num -= 4;
+    }
     while (num--) {
-        *p++ = (unsigned char)value;
+        *p++ = byte;
     }
     return ptr;
 }
+
+static void* memcpy_scalar(void* dest, const void* src, size_t num) {
+    unsigned char* d = (unsigned char*)dest;
+    const unsigned char* s = (const unsigned char*)src;
+
+    if (num >= STRING_ERMSB_MIN && cpu_has(CPU_FEATURE_ERMSB)) {
+        __asm__ volatile ("rep movsb"
+                          : "+D"(d), "+S"(s), "+c"(num)
+                          :
+                          : "memory");
+        return dest;
+    }
+
+    if (num >= STRING_BULK_MIN) {
+        while ((uint32_t)d & 3) {
+            *d++ = *s++;
+            num--;
+        }
+        size_t words = num >> 2;
+        __asm__ volatile ("rep movsl"
+                          : "+D"(d), "+S"(s), "+c"(words)
+                          :
+                          : "memory");
+        num &= 3;
+    }
+
+    /* Unaligned word moves for short blocks: GCC would otherwise turn
+     * the byte loop into single (microcoded) movsb instructions */
+    while (num >= 4) {
+        *(word_t*)d = *(const word_t*)s;
+        d += 4;
+        s += 4;
+        num -= 4;
+    }
+    while (num--) {
+        *d++ = *s++;
+    }
+    return dest;
+}
+
+/*
+ * Overlapping copies with dest above src run backwards: the tail bytes
+ * by hand, then std/rep movsl from the last word down (the direction
+ * flag is cleared again straight after, as the ABI requires).
+ */
+void* memmove(void* dest, const void* src, size_t num) {
+    unsigned char* d = (unsigned char*)dest;
+    const unsigned char* s = (const unsigned char*)src;
+
+    if (d + num <= s || d >= s + num)
+        return memcpy(dest, src, num);
+    if (d < s)
+        return memcpy_scalar(dest, src, num);   /* Forward rep movs is overlap safe */
+
+    d += num;
+    s += num;
+
+    if (num >= STRING_BULK_MIN) {
+        while ((uint32_t)d & 3) {
+            *--d = *--s;
+            num--;
+        }
+        size_t words = num >> 2;
+        unsigned char* dw = d - 4;
+        const unsigned char* sw = s - 4;
+        __asm__ volatile ("std\n\t"
+                          "rep movsl\n\t"
+                          "cld"
+                          : "+D"(dw), "+S"(sw), "+c"(words)
+                          :
+                          : "memory");
+        d = dw + 4;
+        s = sw + 4;
+        num &= 3;
+    }
+
+    while (num--) {
+        *--d = *--s;
+    }
+    return dest;
+}
+
+/* Compare a word at a time; drop to bytes only to locate the difference */
+static int memcmp_scalar(const void* ptr1, const void* ptr2, size_t num) {
+    const unsigned char* a = (const unsigned char*)ptr1;
+    const unsigned char* b = (const unsigned char*)ptr2;
+
+    while (num >= 4 && *(const word_t*)a == *(const word_t*)b) {
+        a += 4;
+        b += 4;
+        num -= 4;
+    }
+    while (num--) {
+        if (*a != *b)
+            return *a - *b;
+        a++;
+        b++;
+    }
+    return 0;
+}
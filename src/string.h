@@ -4,10 +4,31 @@
 
 #include "types.h"
 
+/* Sizes from which memset/memcpy/memmove use rep string instructions */
+#define STRING_BULK_MIN   32    /* rep stosl / movsl */
+#define STRING_ERMSB_MIN  128   /* rep stosb / movsb on ERMSB CPUs */
+#define STRING_SSE2_MIN   64    /* SSE2 memset / memcpy */
+
 size_t strlen(const char* str);
+size_t strnlen(const char* str, size_t maxlen);
 int strcmp(const char* str1, const char* str2);
+int strncmp(const char* str1, const char* str2, size_t n);
 char* strcpy(char* dest, const char* src);
 char* strncpy(char* dest, const char* src, size_t n);
 void* memset(void* ptr, int value, size_t num);
+void* memcpy(void* dest, const void* src, size_t num);
+void* memmove(void* dest, const void* src, size_t num);
+int memcmp(const void* ptr1, const void* ptr2, size_t num);
+void* memchr(const void* ptr, int value, size_t num);
+
+/* strlen/memset/memcpy/memcmp dispatch: SSE2 when enabled, else scalar */
+int string_use_sse2(int enable);
+int string_sse2_active(void);
+
+/* SSE2 kernels from string_sse2.S, valid only for the sizes noted */
+void* memcpy_sse2(void* dest, const void* src, size_t num);      /* num >= 32 */
+void* memset_sse2(void* ptr, int value, size_t num);            /* num >= 32 */
+int memcmp_sse2(const void* ptr1, const void* ptr2, size_t num); /* num >= 16 */
+size_t strlen_sse2(const char* str);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,98 @@
+/* timer.c - PIT tick and TSC calibration against the 8254 PIT */
+#include "timer.h"
+#include "interrupt.h"
+#include "process.h"
+#include "event.h"
+#include "klog.h"
+#include "cpu.h"
+#include "io.h"
+#include "cmdline.h"
+#include "initcall.h"
+
+#define PIT_FREQUENCY     1193182   /* Input clock of the 8254 in Hz */
+#define PIT_CH0_DATA      0x40
+#define PIT_CH2_DATA      0x42
+#define PIT_COMMAND       0x43
+#define PIT_PORT_B        0x61      /* Channel 2 gate (bit 0) and output (bit 5) */
+
+#define CALIBRATE_MS      5    /* Longest boot phase; +-1 PIT clock is 0.02% */
+
+static uint32_t tsc_khz = 0;
+static volatile uint32_t ticks = 0;
+static uint32_t tick_hz = 0;
+
+/*
+ * Count TSC cycles while PIT channel 2 runs a one-shot of CALIBRATE_MS.
+ * Channel 2 is used because its output can be polled through port 0x61
+ * without taking an interrupt.
+ */
+void timer_calibrate_tsc(void) {
+    uint32_t latch = PIT_FREQUENCY / (1000 / CALIBRATE_MS);
+
+    /* Gate high, speaker off */
+    outb(PIT_PORT_B, (inb(PIT_PORT_B) & ~0x02) | 0x01);
+
+    /* Channel 2, lobyte/hibyte, mode 0 (interrupt on terminal count) */
+    outb(PIT_COMMAND, 0xB0);
+    outb(PIT_CH2_DATA, latch & 0xFF);
+    outb(PIT_CH2_DATA, (latch >> 8) & 0xFF);
+
+    uint64_t start = rdtsc();
+    while (!(inb(PIT_PORT_B) & 0x20));
+    uint64_t elapsed = rdtsc() - start;
+
+    tsc_khz = (uint32_t)div64_u32(elapsed, CALIBRATE_MS);
+    if (tsc_khz == 0)
+        tsc_khz = 1;
+
+    klog(KLOG_INFO, "TSC calibrated: %u MHz", tsc_khz / 1000);
+}
+
+static void timer_irq_handler(interrupt_frame_t *frame) {
+    (void)frame;
+    ticks++;
+    process_timer_tick();
+    event_timer_tick();
+}
+
+/* Start PIT channel 0 as a periodic 'hz' interrupt source on IRQ 0 */
+void timer_initialize(uint32_t hz) {
+    uint32_t divisor = PIT_FREQUENCY / hz;
+
+    tick_hz = hz;
+    outb(PIT_COMMAND, 0x36);        /* Channel 0, lobyte/hibyte, mode 3 */
+    outb(PIT_CH0_DATA, divisor & 0xFF);
+    outb(PIT_CH0_DATA, (divisor >> 8) & 0xFF);
+
+    irq_install_handler(IRQ_TIMER, timer_irq_handler);
+    irq_enable(IRQ_TIMER);
+    klog(KLOG_INFO, "PIT timer running at %u Hz", hz);
+}
+
+static int tsc_init(void) {
+    timer_calibrate_tsc();
+    return 0;
+}
+INITCALL("tsc_calibrate", tsc_init, INIT_LEVEL_DEVICE, NULL);
+
+static int timer_init(void) {
+    timer_initialize(boot_config.timer_hz);
+    return 0;
+}
+INITCALL("timer", timer_init, INIT_LEVEL_DEVICE, "interrupt");
+
+uint32_t timer_ticks(void) {
+    return ticks;
+}
+
+uint32_t timer_hz(void) {
+    return tick_hz;
+}
+
+uint32_t timer_tsc_khz(void) {
+    return tsc_khz;
+}
+
+uint32_t timer_cycles_to_us(uint64_t cycles) {
+    return (uint32_t)div64_u32(cycles * 1000, tsc_khz);
+}
@@ -0,0 +1,20 @@
+/* timer.h - Time keeping interface */
+#ifndef TIMER_H
+#define TIMER_H
+
+#include "types.h"
+
+/* Default periodic tick rate (hz= on the command line overrides it);
+ * below 19 Hz the PIT divisor no longer fits in 16 bits */
+#define TIMER_HZ     100
+#define TIMER_HZ_MIN 19
+#define TIMER_HZ_MAX 10000
+
+void timer_initialize(uint32_t hz);
+uint32_t timer_ticks(void);
+uint32_t timer_hz(void);
+void timer_calibrate_tsc(void);
+uint32_t timer_tsc_khz(void);
+uint32_t timer_cycles_to_us(uint64_t cycles);
+
+#endif
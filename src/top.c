@@ -0,0 +1,257 @@
+/* top.c - Live view of CPU, memory and scheduler activity */
+#include "types.h"
+#include "string.h"
+#include "serial.h"
+#include "keyboard.h"
+#include "memory.h"
+#include "process.h"
+#include "interrupt.h"
+#include "timer.h"
+#include "cpu.h"
+#include "event.h"
+#include "kprintf.h"
+#include "cmdline.h"
+#include "shell.h"
+
+#define TOP_COLS        80
+#define TOP_SCREEN_ROWS 24
+#define TOP_HEADER      4       /* Summary, heap, blank, column titles */
+#define TOP_ROWS        (TOP_SCREEN_ROWS - 1)   /* The cursor parks on the last line */
+#define TOP_MERGE_GAP   8       /* Unchanged run cheaper to resend than a cursor move */
+#define TOP_INTERVAL_MAX 60
+
+/*
+ * The terminal is redrawn by difference: each frame is laid out as
+ * fixed-width lines, compared with what the terminal shows, and only
+ * the changed runs are sent, each after an ANSI cursor move. A steady
+ * system costs a few bytes a second; the monitor barely adds load.
+ */
+static char shown[TOP_ROWS][TOP_COLS];
+static int shown_rows;
+
+static char out[256];
+static size_t out_len;
+
+/* Counters at the previous frame; a slot whose process changed starts from 0 */
+static struct {
+    void (*entry)(void);
+    uint32_t cpu_ticks;
+    uint32_t switches;
+} prev[MAX_PROCS];
+static sched_stats_t prev_stats;
+
+static void top_flush(void) {
+    serial_write(out, out_len);
+    out_len = 0;
+}
+
+static void top_emit(const char *s, size_t len) {
+    while (len) {
+        size_t n = sizeof(out) - out_len;
+        if (n > len)
+            n = len;
+        memcpy(out + out_len, s, n);
+        out_len += n;
+        s += n;
+        len -= n;
+        if (out_len == sizeof(out))
+            top_flush();
+    }
+}
+
+static void top_move(int row, int col) {
+    char seq[16];
+    top_emit(seq, ksnprintf(seq, sizeof(seq), "\033[%d;%dH", row + 1, col + 1));
+}
+
+/* Send the parts of 'line' that differ from what row shows */
+static int top_update(int row, const char *line) {
+    char *old = shown[row];
+    int col = 0, sent = 0;
+
+    while (col < TOP_COLS) {
+        int start, end, same;
+
+        if (old[col] == line[col]) {
+            col++;
+            continue;
+        }
+        start = end = col;
+        /* Extend across short unchanged gaps to save cursor moves */
+        for (same = 0; col < TOP_COLS && same < TOP_MERGE_GAP; col++) {
+            if (old[col] == line[col]) {
+                same++;
+            } else {
+                same = 0;
+                end = col;
+            }
+        }
+        top_move(row, start);
+        top_emit(line + start, end - start + 1);
+        memcpy(old + start, line + start, end - start + 1);
+        col = end + 1;
+        sent = 1;
+    }
+    return sent;
+}
+
+/* Format into a full-width line, space padded so old text is overwritten */
+static void top_line(char *line, const char *fmt, ...) {
+    char buf[TOP_COLS + 1];
+    va_list args;
+    size_t len;
+
+    va_start(args, fmt);
+    len = kvsnprintf(buf, sizeof(buf), fmt, args);
+    va_end(args);
+    if (len > TOP_COLS)
+        len = TOP_COLS;
+    memcpy(line, buf, len);
+    memset(line + len, ' ', TOP_COLS - len);
+}
+
+static uint32_t percent(uint32_t part, uint32_t whole) {
+    return whole ? (uint32_t)div64_u32((uint64_t)part * 100, whole) : 0;
+}
+
+static void top_frame(void) {
+    static char frame[TOP_ROWS][TOP_COLS];
+    sched_stats_t stats;
+    memory_stats_t mem;
+    uint32_t dt, idle = 0, runq, procs = 0, hidden = 0, flags;
+    int rows = TOP_HEADER, changed = 0;
+
+    /* Snapshot the table so the frame is consistent */
+    static pcb_t snap[MAX_PROCS];
+    flags = irq_save();
+    memcpy(snap, proctab, sizeof(snap));
+    process_get_sched_stats(&stats);
+    irq_restore(flags);
+    memory_get_stats(&mem);
+
+    dt = stats.ticks - prev_stats.ticks;
+    runq = dt ? (uint32_t)div64_u32((uint64_t)(stats.runq_ticks - prev_stats.runq_ticks) * 100, dt) : 0;
+
+    top_line(frame[3], "  PID NAME         STATE     PRIO    CPU%%   CSW/s   STACK");
+    for (int i = 0; i < process_max(); i++) {
+        pcb_t *p = &snap[i];
+        uint32_t cpu, sw;
+
+        if (p->state == PR_TERMINATED) {
+            prev[i].entry = NULL;
+            continue;
+        }
+        if (prev[i].entry != p->entry || p->cpu_ticks < prev[i].cpu_ticks ||
+            p->switches < prev[i].switches) {
+            prev[i].cpu_ticks = 0;
+            prev[i].switches = 0;
+        }
+        cpu = p->cpu_ticks - prev[i].cpu_ticks;
+        sw = p->switches - prev[i].switches;
+        prev[i].entry = p->entry;
+        prev[i].cpu_ticks = p->cpu_ticks;
+        prev[i].switches = p->switches;
+        if (i == NULLPROC)
+            idle = cpu;
+        procs++;
+
+        if (rows == TOP_ROWS) {
+            hidden++;
+            continue;
+        }
+        top_line(frame[rows++], "%5d %-12s %-8s %3d/%-3d %4u%% %7u %7u", i,
+                 p->name ? p->name : "-", process_state_name(p->state),
+                 p->priority, p->dyn_priority, percent(cpu, dt),
+                 dt ? (uint32_t)div64_u32((uint64_t)sw * timer_hz(), dt) : 0, p->memsz);
+    }
+    /* More processes than the screen holds: the last row counts the rest */
+    if (hidden)
+        top_line(frame[rows - 1], "  ... %u more processes not shown", hidden + 1);
+
+    top_line(frame[0], "top - up %u s, %u processes, run queue %u.%02u, %u switches/s",
+             timer_ticks() / timer_hz(), procs, runq / 100, runq % 100,
+             dt ? (uint32_t)div64_u32((uint64_t)(stats.switches - prev_stats.switches) * timer_hz(), dt) : 0);
+    top_line(frame[1], "CPU %3u%% busy %3u%% idle    Heap %u/%u KB used, largest free %u B, %u blocks",
+             dt ? 100 - percent(idle, dt) : 0, percent(idle, dt), mem.used / 1024, mem.heap_size / 1024,
+             mem.largest_free, mem.blocks);
+    top_line(frame[2], "");
+    prev_stats = stats;
+
+    /* Rows left over from a longer table are blanked */
+    for (int r = rows; r < shown_rows; r++)
+        top_line(frame[r], "");
+    for (int r = 0; r < rows || r < shown_rows; r++)
+        changed |= top_update(r, frame[r]);
+    shown_rows = rows;
+
+    if (changed)
+        top_move(rows, 0);    /* Park the cursor under the table */
+    top_flush();
+}
+
+static int top_command(int argc, char **argv) {
+    uint32_t interval = 1, frames = 0;
+    event_ready_t ready[4];
+    serial_output_t mirror;
+    int set, timer;
+
+    if (argc > 3 ||
+        (argc > 1 && (cmdline_parse_number(argv[1], &interval) != 0 ||
+                      interval == 0 || interval > TOP_INTERVAL_MAX)) ||
+        (argc > 2 && cmdline_parse_number(argv[2], &frames) != 0))
+        return SHELL_USAGE;
+
+    set = event_set_create();
+    timer = event_timer_create(interval * timer_hz());
+    if (set < 0 || timer < 0) {
+        kprintf("No free event sets or timers\n");
+        event_close(timer);
+        event_set_destroy(set);
+        return SHELL_OK;
+    }
+    event_set_add(set, EVENT_SERIAL_RX + SERIAL_CONSOLE, 0);
+    event_set_add(set, EVENT_KEYBOARD, 1);
+    event_set_add(set, timer, 2);
+
+    /*
+     * The VGA mirror does not interpret ANSI escapes and would show the
+     * cursor moves as text; it is suspended while top owns the terminal.
+     * A cleared screen matches the all-blank 'shown'.
+     */
+    mirror = serial_set_console_mirror(NULL);
+    memset(shown, ' ', sizeof(shown));
+    shown_rows = 0;
+    memset(prev, 0, sizeof(prev));
+    process_get_sched_stats(&prev_stats);
+    serial_puts("\033[2J\033[H");
+    top_frame();
+
+    for (uint32_t n = 1; !frames || n < frames; ) {
+        int count = event_set_wait(set, ready, 4, EVENT_WAIT_FOREVER);
+        int quit = 0;
+
+        for (int i = 0; i < count; i++) {
+            if (ready[i].data == 2) {
+                event_take(timer);
+                top_frame();
+                n++;
+            } else {
+                int c = ready[i].data == 0 ? serial_port_try_getc(SERIAL_CONSOLE)
+                                           : keyboard_try_getc();
+                if (c == 'q' || c == 3)
+                    quit = 1;
+            }
+        }
+        if (quit)
+            break;
+    }
+
+    event_close(timer);
+    event_set_destroy(set);
+    top_move(shown_rows, 0);
+    top_flush();
+    serial_set_console_mirror(mirror);
+    return SHELL_OK;
+}
+SHELL_COMMAND("top", top_command, "[seconds] [frames]",
+              "Live per-process CPU%, switches, run queue and heap ('q' quits)");
@@ -2,9 +2,11 @@
 #ifndef TYPES_H
 #define TYPES_H
 
+typedef unsigned long long uint64_t;
 typedef unsigned int   uint32_t;
 typedef unsigned short uint16_t;
 typedef unsigned char  uint8_t;
+typedef long long      int64_t;
 typedef int            int32_t;
 typedef short          int16_t;
 typedef char           int8_t;
@@ -0,0 +1,156 @@
+/* vga.c - VGA text console with CRTC start-address scrolling */
+#include "vga.h"
+#include "interrupt.h"
+#include "io.h"
+#include "serial.h"
+#include "klog.h"
+#include "string.h"
+#include "shell.h"
+
+#define VGA_MEMORY      0xB8000
+#define VGA_MEM_CELLS   16384       /* 32 KB text window at 0xB8000 */
+#define VGA_SCREEN      (VGA_WIDTH * VGA_HEIGHT)
+
+#define CRTC_INDEX      0x3D4
+#define CRTC_DATA       0x3D5
+#define CRTC_CURSOR_START  0x0A
+#define CRTC_CURSOR_END    0x0B
+#define CRTC_START_HIGH    0x0C
+#define CRTC_START_LOW     0x0D
+#define CRTC_CURSOR_HIGH   0x0E
+#define CRTC_CURSOR_LOW    0x0F
+
+static volatile uint16_t *const vga_mem = (volatile uint16_t *)VGA_MEMORY;
+
+/*
+ * The visible screen is a 25-line window starting at cell 'origin' in the
+ * 32 KB text memory. Scrolling moves the window down one line by
+ * reprogramming the CRTC start address, so no screen data is copied until
+ * the window reaches the end of memory (about every 180 lines).
+ */
+static uint32_t origin = 0;
+static uint32_t row = 0;
+static uint32_t col = 0;
+static uint16_t attr = VGA_ATTR_DEFAULT << 8;
+
+static void crtc_write(uint8_t index, uint8_t value) {
+    outb(CRTC_INDEX, index);
+    outb(CRTC_DATA, value);
+}
+
+static void vga_clear_cells(uint32_t start, uint32_t count) {
+    uint16_t blank = attr | ' ';
+    for (uint32_t i = 0; i < count; i++) {
+        vga_mem[start + i] = blank;
+    }
+}
+
+/* Push origin and cursor to the CRTC; done once per vga_write() */
+static void vga_sync_hardware(void) {
+    uint32_t cursor = origin + row * VGA_WIDTH + col;
+
+    crtc_write(CRTC_START_HIGH, (origin >> 8) & 0xFF);
+    crtc_write(CRTC_START_LOW, origin & 0xFF);
+    crtc_write(CRTC_CURSOR_HIGH, (cursor >> 8) & 0xFF);
+    crtc_write(CRTC_CURSOR_LOW, cursor & 0xFF);
+}
+
+static void vga_scroll(void) {
+    origin += VGA_WIDTH;
+
+    if (origin + VGA_SCREEN > VGA_MEM_CELLS) {
+        /* Out of text memory: move the upper 24 lines back to the top */
+        uint32_t keep = VGA_SCREEN - VGA_WIDTH;
+        for (uint32_t i = 0; i < keep; i++) {
+            vga_mem[i] = vga_mem[origin + i];
+        }
+        origin = 0;
+    }
+    vga_clear_cells(origin + VGA_SCREEN - VGA_WIDTH, VGA_WIDTH);
+}
+
+static void vga_newline(void) {
+    col = 0;
+    if (row + 1 < VGA_HEIGHT)
+        row++;
+    else
+        vga_scroll();
+}
+
+static void vga_put_locked(char c) {
+    switch (c) {
+        case '\n':
+            vga_newline();
+            break;
+        case '\r':
+            col = 0;
+            break;
+        case '\b':
+            if (col > 0)
+                col--;
+            break;
+        case '\t':
+            col = (col + 8) & ~7u;
+            if (col >= VGA_WIDTH)
+                vga_newline();
+            break;
+        default:
+            if ((unsigned char)c < ' ')
+                break;
+            vga_mem[origin + row * VGA_WIDTH + col] = attr | (uint8_t)c;
+            if (++col == VGA_WIDTH)
+                vga_newline();
+            break;
+    }
+}
+
+void vga_write(const char *buf, size_t len) {
+    uint32_t flags = irq_save();
+    for (size_t i = 0; i < len; i++) {
+        vga_put_locked(buf[i]);
+    }
+    vga_sync_hardware();
+    irq_restore(flags);
+}
+
+void vga_set_attr(uint8_t new_attr) {
+    attr = (uint16_t)new_attr << 8;
+}
+
+void vga_clear(void) {
+    uint32_t flags = irq_save();
+    origin = 0;
+    row = 0;
+    col = 0;
+    vga_clear_cells(0, VGA_SCREEN);
+    vga_sync_hardware();
+    irq_restore(flags);
+}
+
+void vga_initialize(void) {
+    /* Underline cursor on scanlines 14-15 */
+    crtc_write(CRTC_CURSOR_START, 14);
+    crtc_write(CRTC_CURSOR_END, 15);
+    vga_clear();
+}
+
+/* on: mirror the console; log: only the kernel log; off: neither */
+static int vga_command(int argc, char **argv) {
+    if (argc != 2)
+        return SHELL_USAGE;
+    if (strcmp(argv[1], "on") == 0) {
+        klog_set_mirror(NULL);
+        serial_set_console_mirror(vga_write);
+    } else if (strcmp(argv[1], "off") == 0) {
+        klog_set_mirror(NULL);
+        serial_set_console_mirror(NULL);
+    } else if (strcmp(argv[1], "log") == 0) {
+        serial_set_console_mirror(NULL);
+        vga_clear();
+        klog_set_mirror(vga_write);
+    } else {
+        return SHELL_USAGE;
+    }
+    return SHELL_OK;
+}
+SHELL_COMMAND("vga", vga_command, "on|off|log", "VGA console mirror (log: kernel log only)");
@@ -0,0 +1,18 @@
+/* vga.h - VGA text-mode console interface */
+#ifndef VGA_H
+#define VGA_H
+
+#include "types.h"
+
+#define VGA_WIDTH   80
+#define VGA_HEIGHT  25
+
+/* Attribute byte: background << 4 | foreground */
+#define VGA_ATTR_DEFAULT  0x07   /* Light grey on black */
+
+void vga_initialize(void);
+void vga_clear(void);
+void vga_write(const char *buf, size_t len);
+void vga_set_attr(uint8_t attr);
+
+#endif
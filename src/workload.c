@@ -0,0 +1,269 @@
+/* workload.c - Synthetic workload processes for load-testing the scheduler and heap */
+#include "types.h"
+#include "string.h"
+#include "memory.h"
+#include "process.h"
+#include "interrupt.h"
+#include "timer.h"
+#include "cpu.h"
+#include "kprintf.h"
+#include "cmdline.h"
+#include "shell.h"
+
+#define WORKLOAD_CAL_LOOPS  100000  /* Spin loops timed to size a burst */
+#define WORKLOAD_HOLD_MAX   16      /* Blocks one worker keeps live */
+
+/* One 'load' run; every field but the priorities is shared by all workers */
+typedef struct {
+    uint32_t procs;         /* n=      workers */
+    uint32_t rounds;        /* rounds= burst/alloc/sleep cycles per worker */
+    uint32_t burst_us;      /* burst=  CPU time per round */
+    uint32_t sleep_ms;      /* sleep=  blocked time per round, 0 for none */
+    uint32_t prio_lo;       /* prio=   p, or lo-hi spread over the workers */
+    uint32_t prio_hi;
+    uint32_t alloc;         /* alloc=  bytes per round, up to: 1/2x..1x */
+    uint32_t hold;          /* hold=   rounds a block stays allocated */
+} workload_params_t;
+
+typedef struct {
+    int32_t pid;
+    int priority;
+    uint32_t seed;
+    uint32_t rounds;        /* Completed */
+    uint32_t allocs;
+    uint32_t alloc_failures;
+    uint64_t finish;        /* Cycles from the start of the run */
+    volatile int done;
+} workload_worker_t;
+
+static workload_params_t params;
+static uint32_t burst_loops;
+static uint32_t sleep_ticks;
+static uint64_t run_start;
+static workload_worker_t workers[MAX_PROCS];
+static uint32_t worker_count;
+
+static const struct {
+    const char *key;
+    uint32_t *field;
+    uint32_t min, max;
+} options[] = {
+    { "n",      &params.procs,    1, MAX_PROCS - 1 },
+    { "rounds", &params.rounds,   1, 1000000 },
+    { "burst",  &params.burst_us, 0, 1000000 },
+    { "sleep",  &params.sleep_ms, 0, 10000 },
+    { "alloc",  &params.alloc,    0, 1024 * 1024 },
+    { "hold",   &params.hold,     0, WORKLOAD_HOLD_MAX },
+};
+
+__attribute__((noinline))
+static void workload_spin(uint32_t loops) {
+    for (volatile uint32_t i = 0; i < loops; i++)
+        ;
+}
+
+/* Convert burst= to spin loops, so a burst is CPU work rather than wall
+ * time and is not stretched by preemption */
+static uint32_t workload_calibrate(uint32_t burst_us) {
+    uint32_t flags = irq_save();
+    uint64_t start = rdtsc();
+    workload_spin(WORKLOAD_CAL_LOOPS);
+    uint32_t us = timer_cycles_to_us(rdtsc() - start);
+    irq_restore(flags);
+
+    if (us == 0)
+        us = 1;
+    return (uint32_t)div64_u32((uint64_t)burst_us * WORKLOAD_CAL_LOOPS, us);
+}
+
+/* Alive until it finishes, is killed, or its slot goes to another process */
+static int workload_alive(const workload_worker_t *w) {
+    return !w->done && proctab[w->pid].state != PR_TERMINATED && proctab[w->pid].arg == w;
+}
+
+static void workload_worker(void) {
+    workload_worker_t *w = process_arg();
+    void *held[WORKLOAD_HOLD_MAX] = { 0 };
+    uint32_t seed = w->seed;
+
+    for (uint32_t r = 0; r < params.rounds; r++) {
+        workload_spin(burst_loops);
+
+        if (params.alloc) {
+            uint32_t slot = params.hold ? r % params.hold : 0;
+            uint32_t size;
+
+            seed = seed * 1103515245u + 12345u;
+            size = params.alloc / 2 + (seed >> 8) % (params.alloc - params.alloc / 2 + 1);
+            memory_deallocate(held[slot]);
+            held[slot] = memory_allocate(size);
+            if (held[slot]) {
+                memset(held[slot], (int)r, size);
+                w->allocs++;
+            } else {
+                w->alloc_failures++;
+            }
+            if (!params.hold) {
+                memory_deallocate(held[slot]);
+                held[slot] = NULL;
+            }
+        }
+
+        if (sleep_ticks)
+            process_sleep(sleep_ticks);
+        w->rounds++;
+    }
+
+    for (uint32_t i = 0; i < WORKLOAD_HOLD_MAX; i++)
+        memory_deallocate(held[i]);
+    w->finish = rdtsc() - run_start;
+    w->done = 1;
+}
+
+/* Cut s at the first c; returns the text after it, or NULL if there is none */
+static char *workload_split(char *s, char c) {
+    for (; *s; s++) {
+        if (*s == c) {
+            *s = '\0';
+            return s + 1;
+        }
+    }
+    return NULL;
+}
+
+static int workload_parse(int argc, char **argv) {
+    static const workload_params_t defaults = { 4, 10, 1000, 10, PRIO_DEFAULT, PRIO_DEFAULT, 0, 0 };
+
+    params = defaults;
+    for (int i = 1; i < argc; i++) {
+        char *value = workload_split(argv[i], '=');
+        uint32_t n;
+        uint32_t o;
+
+        if (!value)
+            return -1;
+
+        if (strcmp(argv[i], "prio") == 0) {
+            char *hi = workload_split(value, '-');
+            if (cmdline_parse_number(value, &params.prio_lo) != 0 ||
+                cmdline_parse_number(hi ? hi : value, &params.prio_hi) != 0 ||
+                params.prio_lo < PRIO_DEFAULT || params.prio_hi >= PRIO_SHELL ||
+                params.prio_lo > params.prio_hi) {
+                kprintf("load: prio must be in %d..%d\n", PRIO_DEFAULT, PRIO_SHELL - 1);
+                return -1;
+            }
+            continue;
+        }
+
+        for (o = 0; o < sizeof(options) / sizeof(options[0]); o++) {
+            if (strcmp(argv[i], options[o].key) == 0)
+                break;
+        }
+        if (o == sizeof(options) / sizeof(options[0]))
+            return -1;
+        if (cmdline_parse_number(value, &n) != 0 || n < options[o].min || n > options[o].max) {
+            kprintf("load: %s must be in %u..%u\n", options[o].key, options[o].min, options[o].max);
+            return -1;
+        }
+        *options[o].field = n;
+    }
+    return 0;
+}
+
+/* Run time is up to the last worker's finish, or up to now if any was killed */
+static void workload_report(uint64_t now) {
+    uint32_t rounds = 0, allocs = 0, failures = 0, finished = 0;
+    uint64_t turnaround = 0, last = 0;
+    uint32_t total_us;
+
+    kprintf("PID  PRIO  ROUNDS    ALLOCS  FAILED   TIME(us)\n");
+    for (uint32_t i = 0; i < worker_count; i++) {
+        workload_worker_t *w = &workers[i];
+
+        if (w->done) {
+            uint32_t us = timer_cycles_to_us(w->finish);
+            kprintf("%3d  %4d  %6u  %8u  %6u  %9u\n", w->pid, w->priority,
+                    w->rounds, w->allocs, w->alloc_failures, us);
+            turnaround += us;
+            finished++;
+            if (w->finish > last)
+                last = w->finish;
+        } else {
+            kprintf("%3d  %4d  %6u  %8u  %6u     killed\n", w->pid, w->priority,
+                    w->rounds, w->allocs, w->alloc_failures);
+        }
+        rounds += w->rounds;
+        allocs += w->allocs;
+        failures += w->alloc_failures;
+    }
+
+    total_us = timer_cycles_to_us(finished == worker_count ? last : now);
+    if (total_us == 0)
+        total_us = 1;
+    kprintf("%u/%u workers done in %u us, mean completion %u us\n", finished, worker_count,
+            total_us, finished ? (uint32_t)div64_u32(turnaround, finished) : 0);
+    kprintf("Throughput: %u rounds/s, %u allocs/s (%u failed)\n",
+            (uint32_t)div64_u32((uint64_t)rounds * 1000000, total_us),
+            (uint32_t)div64_u32((uint64_t)allocs * 1000000, total_us), failures);
+}
+
+static int load_command(int argc, char **argv) {
+    process_attr_t attr = { "load", 0, 0, 0 };
+    uint32_t flags;
+
+    for (uint32_t i = 0; i < worker_count; i++) {
+        if (workload_alive(&workers[i])) {
+            kprintf("load: a previous run is still going (see ps)\n");
+            return SHELL_OK;
+        }
+    }
+    if (workload_parse(argc, argv) != 0)
+        return SHELL_USAGE;
+    if (timer_tsc_khz() == 0) {
+        kprintf("load: needs a calibrated TSC\n");
+        return SHELL_OK;
+    }
+
+    burst_loops = workload_calibrate(params.burst_us);
+    sleep_ticks = params.sleep_ms ? (params.sleep_ms * timer_hz() + 999) / 1000 : 0;
+    kprintf("load: %u x %u rounds: burst %u us, sleep %u ms, prio %u-%u, alloc %u hold %u\n",
+            params.procs, params.rounds, params.burst_us, params.sleep_ms,
+            params.prio_lo, params.prio_hi, params.alloc, params.hold);
+
+    /* Start them together: none runs until all are spawned */
+    flags = irq_save();
+    worker_count = 0;
+    run_start = rdtsc();
+    for (uint32_t i = 0; i < params.procs; i++) {
+        workload_worker_t *w = &workers[worker_count];
+
+        memset(w, 0, sizeof(*w));
+        w->priority = (int)(params.prio_lo + i % (params.prio_hi - params.prio_lo + 1));
+        w->seed = i + 1;
+        attr.priority = w->priority;
+        w->pid = process_spawn(&attr, workload_worker, w);
+        if (w->pid < 0)
+            break;
+        worker_count++;
+    }
+    irq_restore(flags);
+
+    if (worker_count < params.procs)
+        kprintf("load: only %u process slots free\n", worker_count);
+    if (worker_count == 0)
+        return SHELL_OK;
+
+    for (;;) {
+        uint32_t alive = 0;
+        for (uint32_t i = 0; i < worker_count; i++)
+            alive += workload_alive(&workers[i]);
+        if (!alive)
+            break;
+        process_sleep(1);
+    }
+    workload_report(rdtsc() - run_start);
+    return SHELL_OK;
+}
+SHELL_COMMAND("load", load_command,
+              "[n=4] [rounds=10] [burst=<us>] [sleep=<ms>] [prio=p|lo-hi] [alloc=<bytes>] [hold=<rounds>]",
+              "Run synthetic workers; report completion time and throughput");
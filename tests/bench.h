@@ -0,0 +1,71 @@
+/* bench.h - Host microbenchmark timing and regression checks */
+#ifndef BENCH_H
+#define BENCH_H
+
+#include "types.h"
+#include "cpu.h"
+#include "kprintf.h"
+
+#define BENCH_ITERS  256
+#define BENCH_RUNS   31     /* Odd, so the median is one run */
+
+/* Keeps results live so the calls are not optimised away */
+extern volatile uint32_t bench_sink;
+
+/* Cycles per call, median over BENCH_RUNS runs of BENCH_ITERS calls: a
+ * run hit by host preemption or a frequency change does not move it */
+#define TIME_CALLS(result, call)                                  \
+    do {                                                          \
+        uint64_t times[BENCH_RUNS];                               \
+        for (int run = 0; run < BENCH_RUNS; run++) {              \
+            uint64_t t0 = rdtsc();                                \
+            for (int it = 0; it < BENCH_ITERS; it++) {            \
+                bench_sink += (uint32_t)(call);                   \
+            }                                                     \
+            times[run] = rdtsc() - t0;                            \
+        }                                                         \
+        result = (uint32_t)div64_u32(bench_median(times, BENCH_RUNS), \
+                                     BENCH_ITERS);                \
+    } while (0)
+
+/* Same for two calls compared with each other: their runs alternate, so
+ * a slow spell on the host affects both sides alike */
+#define TIME_PAIR(base, base_call, fast, fast_call)               \
+    do {                                                          \
+        uint64_t base_times[BENCH_RUNS], fast_times[BENCH_RUNS];  \
+        for (int run = 0; run < BENCH_RUNS; run++) {              \
+            uint64_t t0 = rdtsc();                                \
+            for (int it = 0; it < BENCH_ITERS; it++) {            \
+                bench_sink += (uint32_t)(base_call);              \
+            }                                                     \
+            uint64_t t1 = rdtsc();                                \
+            for (int it = 0; it < BENCH_ITERS; it++) {            \
+                bench_sink += (uint32_t)(fast_call);              \
+            }                                                     \
+            base_times[run] = t1 - t0;                            \
+            fast_times[run] = rdtsc() - t1;                       \
+        }                                                         \
+        base = (uint32_t)div64_u32(bench_median(base_times, BENCH_RUNS), BENCH_ITERS); \
+        fast = (uint32_t)div64_u32(bench_median(fast_times, BENCH_RUNS), BENCH_ITERS); \
+    } while (0)
+
+uint64_t bench_median(uint64_t *times, int n);
+
+/* Speedup of 'fast' over 'base' in tenths (25 = 2.5x) */
+uint32_t bench_speedup_x10(uint32_t base, uint32_t fast);
+
+/*
+ * Record a regression when 'fast' is not at least min_x100/100 times
+ * quicker than 'base'. Thresholds compare against a reference measured
+ * in the same run, so they hold on any host; they sit well below the
+ * usual speedup so that only a real regression trips them.
+ */
+void bench_expect(const char *what, size_t size, uint32_t base, uint32_t fast,
+                  uint32_t min_x100);
+
+/* Suites; each adds to the regression count through bench_expect() */
+void bench_string(void);
+void bench_memory(void);
+void bench_process(void);
+
+#endif
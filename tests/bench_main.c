@@ -0,0 +1,43 @@
+/* bench_main.c - Host microbenchmark runner (make bench) */
+#include "bench.h"
+
+volatile uint32_t bench_sink;
+static uint32_t bench_regressions = 0;
+
+uint32_t bench_speedup_x10(uint32_t base, uint32_t fast) {
+    return fast ? (uint32_t)div64_u32((uint64_t)base * 10, fast) : 0;
+}
+
+/* Insertion sort; n is small */
+uint64_t bench_median(uint64_t *times, int n) {
+    for (int i = 1; i < n; i++) {
+        uint64_t t = times[i];
+        int j = i;
+        for (; j > 0 && times[j - 1] > t; j--)
+            times[j] = times[j - 1];
+        times[j] = t;
+    }
+    return times[n / 2];
+}
+
+void bench_expect(const char *what, size_t size, uint32_t base, uint32_t fast,
+                  uint32_t min_x100) {
+    uint32_t x100 = fast ? (uint32_t)div64_u32((uint64_t)base * 100, fast) : 0;
+    if (x100 < min_x100) {
+        kprintf("REGRESSION %s at %u bytes: %u.%02ux, expected at least %u.%02ux\n",
+                what, size, x100 / 100, x100 % 100, min_x100 / 100, min_x100 % 100);
+        bench_regressions++;
+    }
+}
+
+int main(void) {
+    cpu_detect_features();
+
+    bench_string();
+    bench_memory();
+    bench_process();
+
+    kprintf("\n%s: %u regressions\n", bench_regressions ? "FAILED" : "PASSED",
+            bench_regressions);
+    return bench_regressions ? 1 : 0;
+}
@@ -0,0 +1,32 @@
+/* bench_process.c - Process table and scheduler decision costs */
+#include "bench.h"
+#include "process.h"
+
+static void idle_entry(void) {
+}
+
+void bench_process(void) {
+    uint32_t create, yield, wakeup;
+
+    process_manager_initialize(DEFAULT_MAX_PROCS, DEFAULT_PROC_STACK_SIZE, SCHED_PRIORITY);
+    TIME_CALLS(create, ({
+        int32_t pid = process_create(idle_entry);
+        proctab[pid].state = PR_TERMINATED;
+        pid;
+    }));
+
+    /* A full table of READY processes: each yield scans all of them */
+    for (int i = 0; i < process_max(); i++)
+        process_create(idle_entry);
+    TIME_CALLS(yield, (process_yield_cpu(), 0));
+
+    TIME_CALLS(wakeup, (process_wakeup_event(EVENT_KEYBOARD), 0));
+
+    kprintf("\n=== process manager (cycles per call, %u processes) ===\n"
+            "process_create         %6u\n"
+            "process_yield_cpu      %6u\n"
+            "process_wakeup_event   %6u\n",
+            process_max(), create, yield, wakeup);
+
+    process_manager_initialize(DEFAULT_MAX_PROCS, DEFAULT_PROC_STACK_SIZE, SCHED_PRIORITY);
+}
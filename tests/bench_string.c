@@ -0,0 +1,189 @@
+/* bench_string.c - String and memory routines against byte loops */
+#include "bench.h"
+#include "string.h"
+
+#define BENCH_MAX_LEN  4096
+
+/* Byte-at-a-time references (what string.c used before), kept out of line
+ * so both sides pay for a call */
+__attribute__((noinline, optimize("no-tree-loop-distribute-patterns")))
+static size_t byte_strlen(const char *s) {
+    size_t len = 0;
+    while (s[len])
+        len++;
+    return len;
+}
+
+__attribute__((noinline))
+static int byte_strcmp(const char *a, const char *b) {
+    while (*a && *a == *b) {
+        a++;
+        b++;
+    }
+    return *(const unsigned char *)a - *(const unsigned char *)b;
+}
+
+__attribute__((noinline, optimize("no-tree-loop-distribute-patterns")))
+static char *byte_strncpy(char *d, const char *s, size_t n) {
+    size_t i;
+    for (i = 0; i < n && s[i]; i++)
+        d[i] = s[i];
+    for (; i < n; i++)
+        d[i] = '\0';
+    return d;
+}
+
+__attribute__((noinline))
+static const void *byte_memchr(const void *p, int c, size_t n) {
+    const unsigned char *s = p;
+    for (size_t i = 0; i < n; i++) {
+        if (s[i] == (unsigned char)c)
+            return s + i;
+    }
+    return NULL;
+}
+
+__attribute__((noinline, optimize("no-tree-loop-distribute-patterns")))
+static void *byte_memset(void *p, int c, size_t n) {
+    unsigned char *d = p;
+    for (size_t i = 0; i < n; i++)
+        d[i] = (unsigned char)c;
+    return p;
+}
+
+__attribute__((noinline, optimize("no-tree-loop-distribute-patterns")))
+static void *byte_memcpy(void *dest, const void *src, size_t n) {
+    unsigned char *d = dest;
+    const unsigned char *s = src;
+    for (size_t i = 0; i < n; i++)
+        d[i] = s[i];
+    return dest;
+}
+
+__attribute__((noinline))
+static int byte_memcmp(const void *a, const void *b, size_t n) {
+    const unsigned char *x = a, *y = b;
+    for (size_t i = 0; i < n; i++) {
+        if (x[i] != y[i])
+            return x[i] - y[i];
+    }
+    return 0;
+}
+
+static char str_a[BENCH_MAX_LEN + 64] __attribute__((aligned(16)));
+static char str_b[BENCH_MAX_LEN + 64] __attribute__((aligned(16)));
+static char dst[BENCH_MAX_LEN + 64] __attribute__((aligned(16)));
+
+static const size_t lengths[] = { 1, 3, 8, 15, 32, 64, 256, 1024, 4096 };
+#define NUM_LENGTHS (sizeof(lengths) / sizeof(lengths[0]))
+
+static void print_pair(uint32_t base, uint32_t fast) {
+    uint32_t x10 = bench_speedup_x10(base, fast);
+    kprintf(" %6u %5u %3u.%ux", base, fast, x10 / 10, x10 % 10);
+}
+
+static void fill_strings(size_t n) {
+    for (size_t k = 0; k < n; k++)
+        str_a[k] = str_b[k] = 'a' + k % 26;
+    str_a[n] = str_b[n] = '\0';
+}
+
+static void bench_str(void) {
+    kprintf("\n=== byte vs word-at-a-time (cycles per call) ===\n"
+            "  len %20s %20s %20s %20s\n", "strlen", "strcmp", "strncpy", "memchr");
+    for (size_t i = 0; i < NUM_LENGTHS; i++) {
+        size_t n = lengths[i];
+        uint32_t b[4], w[4];
+
+        fill_strings(n);
+        TIME_PAIR(b[0], byte_strlen(str_a),
+                  w[0], strlen(str_a));
+        TIME_PAIR(b[1], byte_strcmp(str_a, str_b),
+                  w[1], strcmp(str_a, str_b));
+        TIME_PAIR(b[2], (uint32_t)byte_strncpy(dst, str_a, n + 1),
+                  w[2], (uint32_t)strncpy(dst, str_a, n + 1));
+        TIME_PAIR(b[3], (uint32_t)byte_memchr(str_a, '\0', n + 1),
+                  w[3], (uint32_t)memchr(str_a, '\0', n + 1));
+
+        kprintf("%5u", n);
+        for (int k = 0; k < 4; k++)
+            print_pair(b[k], w[k]);
+        kprintf("\n");
+
+        if (n >= 1024) {
+            bench_expect("strlen", n, b[0], w[0], 120);
+            bench_expect("strcmp", n, b[1], w[1], 150);
+            bench_expect("strncpy", n, b[2], w[2], 140);
+            bench_expect("memchr", n, b[3], w[3], 140);
+        }
+    }
+}
+
+static void bench_mem(void) {
+    kprintf("\n=== byte loop vs memset/memcpy/memcmp (cycles per call) ===\n"
+            "  len %20s %20s %20s\n", "memset", "memcpy", "memcmp");
+    fill_strings(BENCH_MAX_LEN);
+    for (size_t i = 0; i < NUM_LENGTHS; i++) {
+        size_t n = lengths[i];
+        uint32_t b[3], f[3];
+
+        TIME_PAIR(b[0], (uint32_t)byte_memset(dst, 'x', n),
+                  f[0], (uint32_t)memset(dst, 'x', n));
+        TIME_PAIR(b[1], (uint32_t)byte_memcpy(dst, str_a, n),
+                  f[1], (uint32_t)memcpy(dst, str_a, n));
+        TIME_PAIR(b[2], byte_memcmp(str_a, str_b, n),
+                  f[2], memcmp(str_a, str_b, n));
+
+        kprintf("%5u", n);
+        for (int k = 0; k < 3; k++)
+            print_pair(b[k], f[k]);
+        kprintf("\n");
+
+        if (n >= 1024) {
+            bench_expect("memset", n, b[0], f[0], 200);
+            bench_expect("memcpy", n, b[1], f[1], 200);
+            bench_expect("memcmp", n, b[2], f[2], 150);
+        }
+    }
+}
+
+/* The SSE2 kernels only accept blocks above their minimum sizes */
+static void bench_sse2(void) {
+    if (!cpu_has(CPU_FEATURE_SSE2))
+        return;
+
+    kprintf("\n=== scalar vs SSE2 (cycles per call) ===\n"
+            "  len %20s %20s %20s %20s\n", "memset", "memcpy", "memcmp", "strlen");
+    for (size_t i = 0; i < NUM_LENGTHS; i++) {
+        size_t n = lengths[i];
+        uint32_t s[4], v[4];
+
+        if (n < 64)
+            continue;
+        fill_strings(n);
+        TIME_PAIR(s[0], (uint32_t)memset(dst, 'x', n),
+                  v[0], (uint32_t)memset_sse2(dst, 'x', n));
+        TIME_PAIR(s[1], (uint32_t)memcpy(dst, str_a, n),
+                  v[1], (uint32_t)memcpy_sse2(dst, str_a, n));
+        TIME_PAIR(s[2], memcmp(str_a, str_b, n),
+                  v[2], memcmp_sse2(str_a, str_b, n));
+        TIME_PAIR(s[3], strlen(str_a),
+                  v[3], strlen_sse2(str_a));
+
+        kprintf("%5u", n);
+        for (int k = 0; k < 4; k++)
+            print_pair(s[k], v[k]);
+        kprintf("\n");
+
+        if (n >= 1024) {
+            bench_expect("memcmp_sse2", n, s[2], v[2], 130);
+            bench_expect("strlen_sse2", n, s[3], v[3], 150);
+        }
+    }
+}
+
+void bench_string(void) {
+    bench_str();
+    bench_mem();
+    bench_sse2();
+}
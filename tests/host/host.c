@@ -0,0 +1,72 @@
+/* host.c - Program entry and serial shim for host builds */
+#include "serial.h"
+#include "timer.h"
+
+int main(void);
+
+static int syscall3(int nr, int a, int b, int c) {
+    int ret;
+    __asm__ volatile ("int $0x80"
+                      : "=a"(ret)
+                      : "a"(nr), "b"(a), "c"(b), "d"(c)
+                      : "memory");
+    return ret;
+}
+
+#define SYS_EXIT   1
+#define SYS_WRITE  4
+
+void host_exit(int status) {
+    syscall3(SYS_EXIT, status, 0, 0);
+    for (;;);
+}
+
+int host_write(int fd, const void *buf, size_t len) {
+    return syscall3(SYS_WRITE, fd, (int)buf, (int)len);
+}
+
+void _start(void) {
+    host_exit(main());
+}
+
+/* Console output goes to stdout unless muted; there is no input */
+static int console_enabled = 1;
+
+void host_console_enable(int enabled) {
+    console_enabled = enabled;
+}
+
+void serial_write(const char *buf, size_t len) {
+    if (console_enabled)
+        host_write(1, buf, len);
+}
+
+void serial_putc(char c) {
+    serial_write(&c, 1);
+}
+
+void serial_puts(const char *str) {
+    size_t len = 0;
+    while (str[len])
+        len++;
+    serial_write(str, len);
+}
+
+void serial_flush(void) {
+}
+
+uint32_t serial_tx_space(void) {
+    return 0xFFFFFFFF;
+}
+
+/* No PIT calibration here: klog timestamps read as zero */
+uint32_t timer_tsc_khz(void) {
+    return 0;
+}
+
+/* Processes never switch stacks on the host; the scheduler's choice is
+ * still visible through currpid */
+void ctxsw(uint32_t **old, uint32_t **new) {
+    (void)old;
+    (void)new;
+}
@@ -0,0 +1,34 @@
+/* host.h - Force-included when building kernel sources as Linux programs */
+#ifndef HOST_H
+#define HOST_H
+
+/*
+ * The host build compiles the same sources with the same flags, as i386
+ * user-mode programs with no libc. cli/sti/hlt and port I/O fault at
+ * CPL 3, so this header claims the include guards of interrupt.h and
+ * io.h first and supplies harmless stand-ins.
+ */
+#define INTERRUPT_H
+#define IO_H
+
+#include "types.h"
+
+#define EFLAGS_IF  0x200
+
+static inline uint32_t irq_save(void) { return EFLAGS_IF; }
+static inline void irq_restore(uint32_t flags) { (void)flags; }
+static inline int irq_enabled(void) { return 1; }
+static inline void interrupts_enable(void) { }
+static inline void interrupts_disable(void) { }
+static inline void cpu_idle(void) { }
+
+static inline void outb(uint16_t port, uint8_t val) { (void)port; (void)val; }
+static inline uint8_t inb(uint16_t port) { (void)port; return 0; }
+static inline void io_wait(void) { }
+
+/* Provided by host.c */
+void host_exit(int status) __attribute__((noreturn));
+int host_write(int fd, const void *buf, size_t len);
+void host_console_enable(int enabled);
+
+#endif
@@ -0,0 +1,65 @@
+/* test_cmdline.c - Multiboot command line options */
+#include "tests.h"
+#include "cmdline.h"
+#include "memory.h"
+#include "process.h"
+#include "timer.h"
+#include "string.h"
+
+static const boot_config_t defaults = {
+    DEFAULT_HEAP_SIZE, DEFAULT_MAX_PROCS, DEFAULT_PROC_STACK_SIZE,
+    TIMER_HZ, SCHED_PRIORITY, 0, 0
+};
+
+/* Parse 'line' as a loader would pass it, from the default settings */
+static void boot_with(uint32_t flags, const char *line) {
+    multiboot_info_t mbi = { flags, 640, 64512, 0, (uint32_t)line };
+
+    boot_config = defaults;
+    cmdline_initialize(MULTIBOOT_BOOTLOADER_MAGIC, &mbi);
+}
+
+void test_cmdline(void) {
+    host_console_enable(0);
+
+    /* The image path is skipped; no options keeps every default */
+    boot_with(MULTIBOOT_INFO_CMDLINE, "kernel.elf");
+    CHECK(memcmp(&boot_config, &defaults, sizeof(defaults)) == 0);
+    CHECK(strcmp(cmdline_get(), "") == 0);
+
+    boot_with(MULTIBOOT_INFO_CMDLINE | MULTIBOOT_INFO_MEMORY,
+              "/boot/kernel.elf  heap=1M procs=32 stack=0x2000 hz=1000 sched=rr bench");
+    CHECK(boot_config.heap_size == 1024 * 1024);
+    CHECK(boot_config.max_procs == 32);
+    CHECK(boot_config.proc_stack_size == 8192);
+    CHECK(boot_config.timer_hz == 1000);
+    CHECK(boot_config.sched_policy == SCHED_ROUND_ROBIN);
+    CHECK(boot_config.bench == 1);
+    CHECK(boot_config.mem_upper_kb == 64512);
+    CHECK(strcmp(cmdline_get(), "heap=1M procs=32 stack=0x2000 hz=1000 sched=rr bench") == 0);
+
+    boot_with(MULTIBOOT_INFO_CMDLINE, "k heap=256k sched=prio");
+    CHECK(boot_config.heap_size == 256 * 1024);
+    CHECK(boot_config.sched_policy == SCHED_PRIORITY);
+    CHECK(boot_config.mem_upper_kb == 0);
+
+    /* Out of range, malformed and unknown options leave the defaults */
+    boot_with(MULTIBOOT_INFO_CMDLINE,
+              "k procs=1 procs=65 hz=5 hz=x stack=4G heap=12Q sched=fifo noise noise=1");
+    CHECK(memcmp(&boot_config, &defaults, sizeof(defaults)) == 0);
+
+    /* Later options win; the limits themselves are accepted */
+    boot_with(MULTIBOOT_INFO_CMDLINE, "k procs=2 procs=64 hz=19 stack=1K");
+    CHECK(boot_config.max_procs == MAX_PROCS);
+    CHECK(boot_config.timer_hz == TIMER_HZ_MIN);
+    CHECK(boot_config.proc_stack_size == PROC_STACK_SIZE_MIN);
+
+    /* Without the CMDLINE flag, or without a multiboot loader, nothing is read */
+    boot_with(0, "k procs=2");
+    CHECK(boot_config.max_procs == DEFAULT_MAX_PROCS);
+    boot_config = defaults;
+    cmdline_initialize(0, NULL);
+    CHECK(memcmp(&boot_config, &defaults, sizeof(defaults)) == 0);
+
+    host_console_enable(1);
+}
@@ -0,0 +1,33 @@
+/* test_main.c - Host unit test runner (make test) */
+#include "tests.h"
+#include "cpu.h"
+
+uint32_t test_checks = 0;
+uint32_t test_failures = 0;
+
+void test_report_failure(const char *file, int line, const char *expr) {
+    if (test_failures++ < TEST_MAX_REPORTS)
+        kprintf("FAIL %s:%d: %s\n", file, line, expr);
+}
+
+static void run_suite(const char *name, void (*suite)(void)) {
+    uint32_t checks = test_checks, failures = test_failures;
+
+    suite();
+    kprintf("%-8s %8u checks, %u failures\n", name,
+            test_checks - checks, test_failures - failures);
+}
+
+int main(void) {
+    cpu_detect_features();
+
+    run_suite("string", test_string);
+    run_suite("memory", test_memory);
+    run_suite("process", test_process);
+    run_suite("cmdline", test_cmdline);
+    run_suite("shell", test_shell);
+
+    kprintf("%s: %u checks, %u failures\n", test_failures ? "FAILED" : "PASSED",
+            test_checks, test_failures);
+    return test_failures ? 1 : 0;
+}
@@ -0,0 +1,83 @@
+/* test_memory.c - First-fit heap allocator */
+#include "tests.h"
+#include "memory.h"
+
+#define HEAP_BYTES    DEFAULT_HEAP_SIZE
+#define SMALL_BLOCKS  64
+
+static uint8_t heap[HEAP_BYTES] __attribute__((aligned(16)));
+
+static int disjoint(const uint8_t *a, size_t na, const uint8_t *b, size_t nb) {
+    return a + na <= b || b + nb <= a;
+}
+
+void test_memory(void) {
+    uint8_t *blocks[SMALL_BLOCKS];
+
+    memory_manager_initialize(heap, HEAP_BYTES);
+    CHECK(memory_heap_size() == HEAP_BYTES);
+
+    /* Sizes are rounded to 4 bytes and blocks never overlap */
+    uint8_t *a = memory_allocate(10);
+    uint8_t *b = memory_allocate(100);
+    uint8_t *c = memory_allocate(1);
+    CHECK(a && b && c);
+    CHECK(((uint32_t)a & 3) == 0 && ((uint32_t)b & 3) == 0 && ((uint32_t)c & 3) == 0);
+    CHECK(disjoint(a, 12, b, 100) && disjoint(b, 100, c, 4) && disjoint(a, 12, c, 4));
+
+    /* First fit: a freed block is reused for a request that fits */
+    memory_deallocate(a);
+    CHECK(memory_allocate(8) == a);
+    memory_deallocate(a);
+    memory_deallocate(b);
+    memory_deallocate(c);
+    memory_deallocate(NULL);
+
+    /* Everything freed coalesces back into one block */
+    a = memory_allocate(HEAP_BYTES - 64);
+    CHECK(a != NULL);
+    CHECK(memory_allocate(HEAP_BYTES) == NULL);
+    memory_deallocate(a);
+
+    /* Exhaust the heap with 1 KB blocks, free in a mixed order, retry */
+    int count = 0;
+    while (count < SMALL_BLOCKS && (blocks[count] = memory_allocate(1024)) != NULL) {
+        for (int i = 0; i < 1024; i++)
+            blocks[count][i] = (uint8_t)count;
+        count++;
+    }
+    CHECK(count >= 60 && count < SMALL_BLOCKS);
+
+    int intact = 1;
+    for (int k = 0; k < count; k++) {
+        for (int i = 0; i < 1024; i++)
+            intact &= blocks[k][i] == (uint8_t)k;
+    }
+    CHECK(intact);
+
+    for (int k = 1; k < count; k += 2)
+        memory_deallocate(blocks[k]);
+    CHECK(memory_allocate(2048) == NULL);
+
+    /* Stats see the holes: half the blocks free, none larger than 1 KB */
+    memory_stats_t st;
+    memory_get_stats(&st);
+    CHECK(st.heap_size == HEAP_BYTES && st.largest_free >= 1024 && st.largest_free < 2048);
+    CHECK(st.used == (uint32_t)(count + 1) / 2 * 1024);
+    CHECK(st.free_blocks >= (uint32_t)count / 2 && st.blocks > (uint32_t)count);
+    for (int k = 0; k < count; k += 2)
+        memory_deallocate(blocks[k]);
+
+    a = memory_allocate(HEAP_BYTES - 64);
+    CHECK(a != NULL);
+    memory_deallocate(a);
+
+    /* A smaller region (heap= on the command line) bounds the allocator */
+    memory_manager_initialize(heap, HEAP_SIZE_MIN);
+    CHECK(memory_allocate(HEAP_SIZE_MIN) == NULL);
+    count = 0;
+    while (count < SMALL_BLOCKS && memory_allocate(1024) != NULL)
+        count++;
+    CHECK(count == HEAP_SIZE_MIN / 1024 - 1);
+    memory_manager_initialize(heap, HEAP_BYTES);
+}
@@ -0,0 +1,217 @@
+/* test_process.c - Process table, scheduler choice, sleep/wait and event sets */
+#include "tests.h"
+#include "process.h"
+#include "event.h"
+#include "memory.h"
+
+#define TEST_HEAP_SIZE  (128 * 1024)    /* MAX_PROCS minimum-size stacks */
+
+static uint8_t heap[TEST_HEAP_SIZE] __attribute__((aligned(16)));
+
+/* Never runs: ctxsw() does not switch stacks on the host */
+static void process_body(void) {
+}
+
+static void init_default(void) {
+    process_manager_initialize(DEFAULT_MAX_PROCS, DEFAULT_PROC_STACK_SIZE, SCHED_PRIORITY);
+}
+
+/* The table holds as many processes as the procs= limit allows, pid 0 included */
+static void check_create_and_run(int max_procs) {
+    memory_stats_t before, after;
+
+    memory_get_stats(&before);
+    process_manager_initialize(max_procs, PROC_STACK_SIZE_MIN, SCHED_PRIORITY);
+    CHECK(process_max() == max_procs);
+    CHECK(currpid == &proctab[NULLPROC] && proctab[NULLPROC].state == PR_CURRENT);
+
+    for (int i = 1; i < max_procs; i++)
+        CHECK(process_create(process_body) == i);
+    CHECK(process_create(process_body) == -1);
+
+    /* Each stack looks as if ctxsw() had switched the process out */
+    for (int i = 1; i < max_procs; i++) {
+        uint32_t *sp = proctab[i].esp;
+        CHECK(proctab[i].state == PR_READY && proctab[i].stack_base != NULL);
+        CHECK(sp[0] == EFLAGS_IF && sp[4] == 0);
+        CHECK(sp[5] == (uint32_t)process_body && sp[6] == (uint32_t)process_exit);
+        CHECK(((uint32_t)&sp[7] & 15) == 0);
+    }
+
+    /* They run in table order; the null process only when none can */
+    for (int i = 1; i < max_procs; i++) {
+        process_yield_cpu();
+        CHECK(currpid == &proctab[i]);
+    }
+    for (int i = 1; i < max_procs - 1; i++)
+        CHECK(process_kill(i) == 0);
+    process_sleep(1);
+    CHECK(currpid == &proctab[NULLPROC]);
+    process_timer_tick();
+    CHECK(process_kill(max_procs - 1) == 0);
+    for (int i = 0; i < MAX_PROCS; i++)
+        CHECK(proctab[i].state == (i == NULLPROC ? PR_CURRENT : PR_TERMINATED));
+
+    /* Reaping gives the stacks back; slots are reused from pid 1 */
+    process_reap();
+    memory_get_stats(&after);
+    CHECK(after.used == before.used);
+    CHECK(process_create(process_body) == 1);
+}
+
+static void check_spawn_attributes(void) {
+    static const process_attr_t attr = { "worker", 3, 2048, PROC_F_KERNEL };
+    int arg;
+
+    init_default();
+    int32_t pid = process_spawn(&attr, process_body, &arg);
+    CHECK(pid == 1);
+    CHECK(proctab[pid].name == attr.name && proctab[pid].flags == PROC_F_KERNEL);
+    CHECK(proctab[pid].priority == 3 && proctab[pid].memsz == 2048);
+    CHECK(proctab[pid].arg == &arg);
+
+    pid = process_spawn(NULL, process_body, NULL);
+    CHECK(proctab[pid].priority == PRIO_DEFAULT && proctab[pid].memsz == DEFAULT_PROC_STACK_SIZE);
+
+    process_yield_cpu();
+    CHECK(currpid == &proctab[1] && process_arg() == &arg);
+    CHECK(process_kill(NULLPROC) == -1 && process_kill(MAX_PROCS) == -1);
+    CHECK(process_kill(1) == -1 && proctab[1].state == PR_CURRENT);
+    CHECK(process_kill(2) == 0 && process_kill(2) == -1);
+    init_default();
+    process_reap();
+}
+
+static void check_sleep_and_wait(void) {
+    init_default();
+    process_create(process_body);
+    process_create(process_body);
+
+    proctab[1].state = PR_SLEEP;
+    proctab[1].sleep_ticks = 2;
+    process_timer_tick();
+    CHECK(proctab[1].state == PR_SLEEP);
+    process_timer_tick();
+    CHECK(proctab[1].state == PR_READY);
+
+    proctab[2].state = PR_WAIT;
+    proctab[2].wait_event = EVENT_KEYBOARD;
+    process_wakeup_event(EVENT_CONSOLE_INPUT);
+    CHECK(proctab[2].state == PR_WAIT);
+    process_wakeup_event(EVENT_KEYBOARD);
+    CHECK(proctab[2].state == PR_READY && proctab[2].wait_event == -1);
+}
+
+/* The highest dynamic priority wins; ties go round-robin */
+static void check_scheduler_choice(void) {
+    init_default();
+    for (int i = 0; i < 4; i++)
+        process_create(process_body);
+
+    proctab[2].dyn_priority = 5;
+    process_yield_cpu();
+    CHECK(currpid == &proctab[2] && proctab[2].state == PR_CURRENT);
+    CHECK(proctab[2].dyn_priority == proctab[2].priority);
+
+    process_yield_cpu();
+    CHECK(currpid == &proctab[3]);
+    CHECK(proctab[2].state == PR_READY);
+    process_yield_cpu();
+    CHECK(currpid == &proctab[4]);
+    process_yield_cpu();
+    CHECK(currpid == &proctab[1]);
+
+    CHECK(process_kill(3) == 0 && proctab[3].state == PR_TERMINATED);
+}
+
+/* sched=rr ignores priorities and takes the table in order */
+static void check_round_robin(void) {
+    process_manager_initialize(DEFAULT_MAX_PROCS, DEFAULT_PROC_STACK_SIZE, SCHED_ROUND_ROBIN);
+    for (int i = 0; i < 3; i++)
+        process_create(process_body);
+
+    proctab[2].dyn_priority = 5;
+    for (int i = 0; i < 6; i++) {
+        process_yield_cpu();
+        CHECK(currpid == &proctab[i % 3 + 1]);
+    }
+    init_default();
+}
+
+/* Ticks are charged to the running process; top reads the totals */
+static void check_sched_stats(void) {
+    sched_stats_t stats;
+
+    init_default();
+    process_create(process_body);
+    process_create(process_body);
+    process_timer_tick();
+    CHECK(proctab[NULLPROC].cpu_ticks == 1);
+
+    process_yield_cpu();
+    process_timer_tick();
+    process_timer_tick();
+    process_yield_cpu();
+    CHECK(proctab[1].cpu_ticks == 2 && proctab[1].switches == 1);
+    CHECK(proctab[2].switches == 1 && proctab[2].cpu_ticks == 0);
+
+    process_get_sched_stats(&stats);
+    CHECK(stats.ticks == 3 && stats.switches == 2);
+    CHECK(stats.runq_ticks == 2 + 1 + 1);
+
+    CHECK(process_kill(1) == 0);
+    process_reap();
+    CHECK(process_create(process_body) == 1);
+    CHECK(proctab[1].cpu_ticks == 0 && proctab[1].switches == 0);
+}
+
+static void check_event_sets(void) {
+    event_ready_t ready[4];
+
+    init_default();
+
+    int counter = event_counter_create();
+    int timer = event_timer_create(3);
+    int set = event_set_create();
+    CHECK(counter > 0 && timer > 0 && set >= 0);
+    CHECK(event_set_add(set, counter, 11) == 0);
+    CHECK(event_set_add(set, timer, 22) == 0);
+
+    CHECK(event_set_wait(set, ready, 4, 0) == 0);
+
+    event_counter_signal(counter);
+    event_counter_signal(counter);
+    CHECK(event_set_wait(set, ready, 4, 0) == 1);
+    CHECK(ready[0].event_id == counter && ready[0].data == 11);
+    CHECK(event_take(counter) == 2);
+    CHECK(event_set_wait(set, ready, 4, 0) == 0);
+
+    for (int i = 0; i < 6; i++)
+        event_timer_tick();
+    CHECK(event_set_wait(set, ready, 4, 0) == 1 && ready[0].data == 22);
+    CHECK(event_take(timer) == 2);
+
+    CHECK(event_set_remove(set, counter) == 0);
+    CHECK(event_set_remove(set, counter) == -1);
+    event_set_destroy(set);
+    CHECK(event_set_wait(set, ready, 4, 0) == -1);
+    event_close(counter);
+    event_close(timer);
+}
+
+void test_process(void) {
+    memory_manager_initialize(heap, TEST_HEAP_SIZE);
+    host_console_enable(0);
+    check_create_and_run(DEFAULT_MAX_PROCS);
+    check_create_and_run(PROC_LIMIT_MIN);
+    check_create_and_run(MAX_PROCS);
+    check_spawn_attributes();
+    check_sleep_and_wait();
+    check_scheduler_choice();
+    check_round_robin();
+    check_sched_stats();
+    check_event_sets();
+    init_default();
+    process_reap();
+    host_console_enable(1);
+}
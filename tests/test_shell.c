@@ -0,0 +1,97 @@
+/* test_shell.c - Command registry, lookup and argument splitting */
+#include "tests.h"
+#include "shell.h"
+#include "string.h"
+#include "process.h"
+
+static int last_argc;
+static char *last_argv[SHELL_MAX_ARGS + 1];
+
+static int record_command(int argc, char **argv) {
+    last_argc = argc;
+    for (int i = 0; i <= argc; i++)
+        last_argv[i] = argv[i];
+    return argc > 3 ? SHELL_USAGE : SHELL_OK;
+}
+
+static const shell_command_t echo = { "echo", record_command, "[a [b]]", "Record arguments" };
+static const shell_command_t echo2 = { "echo", record_command, NULL, "Duplicate name" };
+
+static shell_command_t filler[SHELL_MAX_COMMANDS];
+static char filler_names[SHELL_MAX_COMMANDS][8];
+
+void test_shell(void) {
+    char line[64];
+    char *argv[4];
+
+    host_console_enable(0);
+
+    /* Splitting: runs of spaces, leading and trailing spaces, overflow */
+    strcpy(line, "  profile   start 1024 ");
+    CHECK(shell_split(line, argv, 4) == 3);
+    CHECK(strcmp(argv[0], "profile") == 0);
+    CHECK(strcmp(argv[1], "start") == 0);
+    CHECK(strcmp(argv[2], "1024") == 0);
+    strcpy(line, "   ");
+    CHECK(shell_split(line, argv, 4) == 0);
+    strcpy(line, "a b c d e");
+    CHECK(shell_split(line, argv, 4) == -1);
+
+    /* Registration and lookup; names are unique */
+    CHECK(shell_find("echo") == NULL);
+    CHECK(shell_register(&echo) == 0);
+    CHECK(shell_register(&echo2) == -1);
+    CHECK(shell_find("echo") == &echo);
+    CHECK(shell_find("ech") == NULL);
+    CHECK(shell_find("echoo") == NULL);
+
+    /* Dispatch with argc/argv, usage on SHELL_USAGE, unknown commands */
+    strcpy(line, "echo one two");
+    CHECK(shell_execute(line) == SHELL_OK);
+    CHECK(last_argc == 3);
+    CHECK(strcmp(last_argv[2], "two") == 0 && last_argv[3] == NULL);
+    strcpy(line, "echo 1 2 3");
+    CHECK(shell_execute(line) == SHELL_USAGE);
+    strcpy(line, "nosuch arg");
+    CHECK(shell_execute(line) == -1);
+    strcpy(line, "");
+    CHECK(shell_execute(line) == 0);
+    strcpy(line, "echo 1 2 3 4 5 6 7 8");
+    CHECK(shell_execute(line) == -1);
+
+    /* A trailing "&" starts the command in a process of its own */
+    process_manager_initialize(DEFAULT_MAX_PROCS, DEFAULT_PROC_STACK_SIZE, SCHED_PRIORITY);
+    last_argc = 0;
+    strcpy(line, "echo a b &");
+    CHECK(shell_execute(line) == SHELL_OK);
+    CHECK(last_argc == 0);
+    CHECK(proctab[1].state == PR_READY && strcmp(proctab[1].name, "echo") == 0);
+    CHECK(proctab[1].memsz == SHELL_STACK_SIZE && proctab[1].flags == 0);
+    strcpy(line, "&");
+    CHECK(shell_execute(line) == 0);
+    /* The "&" does not count against SHELL_MAX_ARGS */
+    strcpy(line, "echo 1 2 3 4 5 6 7 &");
+    CHECK(shell_execute(line) == SHELL_OK && proctab[2].state == PR_READY);
+    strcpy(line, "echo 1 2 3 4 5 6 7 8 &");
+    CHECK(shell_execute(line) == -1 && proctab[3].state == PR_TERMINATED);
+    CHECK(process_kill(1) == 0 && process_kill(2) == 0);
+    process_reap();
+
+    /* Fill the table: every name stays reachable through the probes */
+    int registered = 1;
+    for (int i = 0; i < SHELL_MAX_COMMANDS; i++) {
+        ksnprintf(filler_names[i], sizeof(filler_names[i]), "c%d", i);
+        filler[i].name = filler_names[i];
+        filler[i].fn = record_command;
+        filler[i].help = "filler";
+        if (shell_register(&filler[i]) == 0)
+            registered++;
+    }
+    CHECK(registered == SHELL_MAX_COMMANDS);
+    CHECK(shell_find("echo") == &echo);
+    for (int i = 0; i < SHELL_MAX_COMMANDS - 1; i++)
+        CHECK(shell_find(filler_names[i]) == &filler[i]);
+    CHECK(shell_find(filler_names[SHELL_MAX_COMMANDS - 1]) == NULL);
+
+    host_console_enable(1);
+}
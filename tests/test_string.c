@@ -0,0 +1,206 @@
+/* test_string.c - string.c and string_sse2.S against byte-loop references */
+#include "tests.h"
+#include "string.h"
+#include "cpu.h"
+
+#define MAX_LEN    300          /* Sizes 0..N-1 at every alignment pair */
+#define MAX_ALIGN  16
+#define BUF_SIZE   (MAX_LEN * 2 + 64)
+#define BIG_SIZE   (70 * 1024)  /* Past the SSE2 non-temporal threshold */
+
+static uint8_t src[BUF_SIZE], dst[BUF_SIZE], ref[BUF_SIZE];
+static uint8_t big_src[BIG_SIZE + 64], big_dst[BIG_SIZE + 64];
+
+/* One set of block routines and the smallest sizes they accept */
+typedef struct {
+    void *(*copy)(void *dest, const void *src, size_t num);
+    void *(*set)(void *ptr, int value, size_t num);
+    int (*cmp)(const void *a, const void *b, size_t num);
+    size_t (*len)(const char *str);
+    size_t min_block;
+    size_t min_cmp;
+} string_impl_t;
+
+__attribute__((optimize("no-tree-loop-distribute-patterns")))
+static void ref_copy(uint8_t *d, const uint8_t *s, size_t n) {
+    for (size_t i = 0; i < n; i++)
+        d[i] = s[i];
+}
+
+__attribute__((optimize("no-tree-loop-distribute-patterns")))
+static void ref_set(uint8_t *p, uint8_t value, size_t n) {
+    for (size_t i = 0; i < n; i++)
+        p[i] = value;
+}
+
+static int ref_equal(const uint8_t *a, const uint8_t *b, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        if (a[i] != b[i])
+            return 0;
+    }
+    return 1;
+}
+
+static void fill(uint8_t *p, size_t n, uint32_t seed) {
+    for (size_t i = 0; i < n; i++)
+        p[i] = (uint8_t)(i * 131 + seed * 7 + 1);
+}
+
+static int sign(int x) {
+    return (x > 0) - (x < 0);
+}
+
+/* copy/set/cmp/len for every size from min_block up, all alignments */
+static void check_blocks(const string_impl_t *impl) {
+    for (size_t n = 0; n < MAX_LEN; n++) {
+        for (int sa = 0; sa < MAX_ALIGN; sa++) {
+            for (int da = 0; da < MAX_ALIGN; da++) {
+                if (n >= impl->min_block) {
+                    fill(src, n + MAX_ALIGN * 2, n);
+                    fill(dst, n + MAX_ALIGN * 2, n + 99);
+                    ref_copy(ref, dst, n + MAX_ALIGN * 2);
+
+                    CHECK(impl->copy(dst + da, src + sa, n) == dst + da);
+                    ref_copy(ref + da, src + sa, n);
+                    CHECK(ref_equal(dst, ref, n + MAX_ALIGN * 2));
+
+                    CHECK(impl->set(dst + da, 0xA5, n) == dst + da);
+                    ref_set(ref + da, 0xA5, n);
+                    CHECK(ref_equal(dst, ref, n + MAX_ALIGN * 2));
+                }
+
+                if (n >= impl->min_cmp) {
+                    fill(src, n + MAX_ALIGN * 2, n);
+                    ref_copy(dst + da, src + sa, n);
+                    CHECK(impl->cmp(dst + da, src + sa, n) == 0);
+                    for (size_t pos = 0; pos < n; pos += 1 + n / 8) {
+                        dst[da + pos] ^= 0x81;
+                        int expect = dst[da + pos] - src[sa + pos];
+                        CHECK(sign(impl->cmp(dst + da, src + sa, n)) == sign(expect));
+                        dst[da + pos] ^= 0x81;
+                    }
+                }
+
+                if (da == 0) {
+                    ref_set(src + sa, 'x', n);
+                    src[sa + n] = '\0';
+                    CHECK(impl->len((const char *)src + sa) == n);
+                }
+            }
+        }
+    }
+}
+
+/* Large blocks take the non-temporal path in the SSE2 kernels */
+static void check_big_blocks(const string_impl_t *impl) {
+    static const size_t sizes[] = { 64 * 1024, 64 * 1024 + 1, BIG_SIZE - 3, BIG_SIZE };
+
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        size_t n = sizes[i];
+        int sa = i * 5 % MAX_ALIGN, da = i * 3 % MAX_ALIGN;
+
+        fill(big_src, BIG_SIZE + 64, n);
+        ref_set(big_dst, 0, BIG_SIZE + 64);
+        impl->copy(big_dst + da, big_src + sa, n);
+        CHECK(ref_equal(big_dst + da, big_src + sa, n));
+        CHECK(big_dst[da + n] == 0);
+        CHECK(impl->cmp(big_dst + da, big_src + sa, n) == 0);
+
+        impl->set(big_dst + da, 0x3C, n);
+        CHECK(big_dst[da] == 0x3C && big_dst[da + n - 1] == 0x3C && big_dst[da + n] == 0);
+        CHECK(impl->cmp(big_dst + da, big_src + sa, n) != 0);
+    }
+}
+
+/* memmove at every overlap distance up to +-40 in both directions */
+static void check_memmove(void) {
+    for (size_t n = 0; n < MAX_LEN; n += 1 + n / 16) {
+        for (int shift = -40; shift <= 40; shift++) {
+            uint8_t *base = src + 64;
+
+            fill(src, BUF_SIZE, n);
+            ref_copy(ref, src, BUF_SIZE);
+            ref_copy(dst, ref + 64, n);
+            ref_copy(ref + 64 + shift, dst, n);
+
+            CHECK(memmove(base + shift, base, n) == base + shift);
+            CHECK(ref_equal(src, ref, BUF_SIZE));
+        }
+    }
+}
+
+static size_t ref_strnlen(const char *s, size_t max) {
+    size_t i = 0;
+    while (i < max && s[i])
+        i++;
+    return i;
+}
+
+static int ref_strncmp(const char *a, const char *b, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        unsigned char ca = a[i], cb = b[i];
+        if (ca != cb || !ca)
+            return ca - cb;
+    }
+    return 0;
+}
+
+/* str* and memchr on strings that differ at sampled positions */
+static void check_strings(void) {
+    for (size_t n = 0; n < 80; n++) {
+        for (int sa = 0; sa < 8; sa++) {
+            for (int da = 0; da < 8; da++) {
+                for (int pos = -1; pos < (int)n; pos += 1 + n / 16) {
+                    char *s1 = (char *)src + sa;
+                    char *s2 = (char *)dst + da;
+
+                    for (size_t i = 0; i < n; i++)
+                        s1[i] = s2[i] = 'a' + (i * 7) % 23;
+                    s1[n] = s2[n] = '\0';
+                    if (pos >= 0)
+                        s2[pos] ^= (pos & 1) ? 0x80 : 0x01;
+
+                    CHECK(sign(strcmp(s1, s2)) == sign(ref_strncmp(s1, s2, n + 1)));
+                    CHECK(strlen(s2) == n);
+                    for (size_t m = 0; m < n + 3; m += 1 + n / 10) {
+                        CHECK(sign(strncmp(s1, s2, m)) == sign(ref_strncmp(s1, s2, m)));
+                        CHECK(strnlen(s1, m) == ref_strnlen(s1, m));
+
+                        char c = s2[pos >= 0 ? pos : 0];
+                        const void *expect = NULL;
+                        for (size_t i = 0; i < m; i++) {
+                            if (s2[i] == c) {
+                                expect = s2 + i;
+                                break;
+                            }
+                        }
+                        CHECK(memchr(s2, c, m) == expect);
+
+                        ref_set(ref, 0x77, da + m + 1);
+                        CHECK(strncpy((char *)ref + da, s1, m) == (char *)ref + da);
+                        size_t copied = ref_strnlen(s1, m);
+                        CHECK(ref_equal(ref + da, (const uint8_t *)s1, copied));
+                        for (size_t i = copied; i < m; i++)
+                            CHECK(ref[da + i] == 0);
+                        CHECK(ref[da + m] == 0x77);
+                    }
+                }
+            }
+        }
+    }
+}
+
+void test_string(void) {
+    string_impl_t scalar = { memcpy, memset, memcmp, strlen, 0, 0 };
+    string_impl_t sse2 = { memcpy_sse2, memset_sse2, memcmp_sse2, strlen_sse2, 32, 16 };
+
+    /* The host never runs cpu_enable_sse(), so memcpy() etc. are scalar */
+    check_blocks(&scalar);
+    check_big_blocks(&scalar);
+    if (cpu_has(CPU_FEATURE_SSE2)) {
+        check_blocks(&sse2);
+        check_big_blocks(&sse2);
+    }
+    check_memmove();
+    check_strings();
+}
@@ -0,0 +1,29 @@
+/* tests.h - Host unit test checks and suites */
+#ifndef TESTS_H
+#define TESTS_H
+
+#include "types.h"
+#include "kprintf.h"
+
+#define TEST_MAX_REPORTS  20    /* Failures printed in full per run */
+
+extern uint32_t test_checks;
+extern uint32_t test_failures;
+
+void test_report_failure(const char *file, int line, const char *expr);
+
+#define CHECK(cond)                                               \
+    do {                                                          \
+        test_checks++;                                            \
+        if (!(cond))                                              \
+            test_report_failure(__FILE__, __LINE__, #cond);       \
+    } while (0)
+
+/* Suites, one per module under test */
+void test_string(void);
+void test_memory(void);
+void test_process(void);
+void test_cmdline(void);
+void test_shell(void);
+
+#endif
@@ -0,0 +1,90 @@
+#!/usr/bin/env python3
+"""benchcsv.py - Collect kacchiOS headless benchmark results into a CSV file.
+
+The benchmark image (make bench-qemu) prints one metric per line:
+
+    BENCH <name> <value> <unit>
+
+between BENCH-BEGIN and BENCH-END markers, after a BENCH-ARGS line with
+the kernel command line. Each run appends one row per metric to the CSV,
+tagged with the run time, the git revision and the boot options, so
+results can be compared run over run and across configurations:
+
+    run,commit,args,metric,value,unit
+
+Usage:
+    benchcsv.py bench.log bench.csv
+"""
+import argparse
+import csv
+import datetime
+import os
+import subprocess
+import sys
+
+FIELDS = ["run", "commit", "args", "metric", "value", "unit"]
+
+
+def git_revision():
+    try:
+        rev = subprocess.run(["git", "rev-parse", "--short", "HEAD"],
+                             capture_output=True, text=True, check=True).stdout.strip()
+        dirty = subprocess.run(["git", "diff", "--quiet", "HEAD"]).returncode != 0
+        return rev + ("-dirty" if dirty else "")
+    except (OSError, subprocess.CalledProcessError):
+        return "unknown"
+
+
+def parse_log(path):
+    """Return (metrics, args, complete): metrics as (name, value, unit) tuples."""
+    metrics = []
+    args = ""
+    began = ended = False
+    with open(path, "r", errors="replace") as log:
+        for line in log:
+            line = line.strip()
+            if line == "BENCH-BEGIN":
+                began = True
+            elif line == "BENCH-END":
+                ended = True
+            elif line.startswith("BENCH-ARGS"):
+                args = line[len("BENCH-ARGS"):].strip()
+            elif line.startswith("BENCH-ERROR"):
+                print(f"benchcsv: {line}", file=sys.stderr)
+            elif began and line.startswith("BENCH "):
+                parts = line.split()
+                if len(parts) != 4:
+                    print(f"benchcsv: malformed line: {line}", file=sys.stderr)
+                    continue
+                _, name, value, unit = parts
+                metrics.append((name, int(value), unit))
+    return metrics, args, began and ended
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("log", help="serial log of the benchmark boot")
+    parser.add_argument("csv", help="CSV file to append to (created with a header)")
+    args = parser.parse_args()
+
+    metrics, boot_args, complete = parse_log(args.log)
+    if not complete:
+        print("benchcsv: run did not reach BENCH-END", file=sys.stderr)
+        return 1
+
+    run = datetime.datetime.now().strftime("%Y-%m-%dT%H:%M:%S")
+    commit = git_revision()
+    new_file = not os.path.exists(args.csv) or os.path.getsize(args.csv) == 0
+    with open(args.csv, "a", newline="") as out:
+        writer = csv.writer(out)
+        if new_file:
+            writer.writerow(FIELDS)
+        for name, value, unit in metrics:
+            writer.writerow([run, commit, boot_args, name, value, unit])
+
+    print(f"benchcsv: {len(metrics)} metrics from {args.log} appended to {args.csv}")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,164 @@
+#!/usr/bin/env python3
+"""muxdemux.py - Host-side demultiplexer for the kacchiOS serialmux protocol.
+
+Frames (see src/serialmux.h):
+
+    0xA5 0x5A | channel:u8 | length:u16le | payload | crc16:u16le
+
+Console text (channel 0) goes to stdout, kernel log text (channel 1) to
+stderr, and every other channel is appended to <out-dir>/chN.bin.
+
+Usage:
+    muxdemux.py trace.bin                  # decode a captured stream
+    muxdemux.py tcp:localhost:4555         # live: QEMU -serial tcp::4555,server
+    muxdemux.py -                          # read the stream from stdin
+
+In tcp mode, keystrokes typed on stdin are forwarded unframed, so the
+shell keeps working while telemetry streams on other channels.
+"""
+import argparse
+import os
+import select
+import socket
+import sys
+import termios
+import tty
+
+SYNC = b"\xA5\x5A"
+HEADER_SIZE = 5
+MAX_PAYLOAD = 256
+CH_CONSOLE = 0
+CH_LOG = 1
+
+
+def crc16_ccitt(data, crc=0xFFFF):
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+            crc &= 0xFFFF
+    return crc
+
+
+class Demux:
+    def __init__(self, out_dir):
+        self.buf = bytearray()
+        self.out_dir = out_dir
+        self.files = {}
+        self.frames = {}
+        self.crc_errors = 0
+        self.skipped = 0
+
+    def feed(self, data):
+        self.buf += data
+        while True:
+            start = self.buf.find(SYNC)
+            if start < 0:
+                # Keep a trailing 0xA5 that may begin the next sync pair
+                keep = 1 if self.buf[-1:] == SYNC[:1] else 0
+                self.skipped += len(self.buf) - keep
+                del self.buf[:len(self.buf) - keep]
+                return
+            if start:
+                self.skipped += start
+                del self.buf[:start]
+            if len(self.buf) < HEADER_SIZE:
+                return
+            channel = self.buf[2]
+            length = self.buf[3] | (self.buf[4] << 8)
+            if length > MAX_PAYLOAD:
+                # Sync bytes inside other data: no frame is this long
+                self.skipped += 1
+                del self.buf[:1]
+                continue
+            total = HEADER_SIZE + length + 2
+            if len(self.buf) < total:
+                return
+            body = bytes(self.buf[2:HEADER_SIZE + length])
+            crc = self.buf[total - 2] | (self.buf[total - 1] << 8)
+            if crc16_ccitt(body) != crc:
+                # Not a real frame boundary: resync one byte further on
+                self.crc_errors += 1
+                self.skipped += 1
+                del self.buf[:1]
+                continue
+            del self.buf[:total]
+            self.deliver(channel, body[3:])
+
+    def deliver(self, channel, payload):
+        self.frames[channel] = self.frames.get(channel, 0) + 1
+        if channel == CH_CONSOLE:
+            sys.stdout.buffer.write(payload.replace(b"\n", b"\r\n") if sys.stdout.isatty() else payload)
+            sys.stdout.buffer.flush()
+        elif channel == CH_LOG:
+            sys.stderr.buffer.write(payload)
+            sys.stderr.buffer.flush()
+        else:
+            f = self.files.get(channel)
+            if f is None:
+                os.makedirs(self.out_dir, exist_ok=True)
+                f = open(os.path.join(self.out_dir, "ch%d.bin" % channel), "ab")
+                self.files[channel] = f
+            f.write(payload)
+
+    def close(self):
+        for f in self.files.values():
+            f.close()
+        summary = ", ".join("ch%d=%d" % kv for kv in sorted(self.frames.items()))
+        sys.stderr.write("\nmuxdemux: frames [%s], crc errors %d, bytes skipped %d\n"
+                         % (summary or "none", self.crc_errors, self.skipped))
+
+
+def run_tcp(target, demux):
+    host, port = target.rsplit(":", 1)
+    sock = socket.create_connection((host, int(port)))
+    interactive = sys.stdin.isatty()
+    saved = termios.tcgetattr(sys.stdin) if interactive else None
+    try:
+        if interactive:
+            tty.setraw(sys.stdin)
+        while True:
+            ready, _, _ = select.select([sock, sys.stdin], [], [])
+            if sock in ready:
+                data = sock.recv(4096)
+                if not data:
+                    break
+                demux.feed(data)
+            if sys.stdin in ready:
+                key = os.read(sys.stdin.fileno(), 64)
+                if not key or b"\x1d" in key:   # Ctrl-] quits
+                    break
+                sock.sendall(key)
+    finally:
+        if saved is not None:
+            termios.tcsetattr(sys.stdin, termios.TCSADRAIN, saved)
+        sock.close()
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("source", help="capture file, '-' for stdin, or tcp:HOST:PORT")
+    parser.add_argument("--out-dir", default="mux_out",
+                        help="directory for binary channel files (default: mux_out)")
+    args = parser.parse_args()
+
+    demux = Demux(args.out_dir)
+    try:
+        if args.source.startswith("tcp:"):
+            run_tcp(args.source[4:], demux)
+        else:
+            stream = sys.stdin.buffer if args.source == "-" else open(args.source, "rb")
+            with stream:
+                while True:
+                    data = stream.read(65536)
+                    if not data:
+                        break
+                    demux.feed(data)
+    except KeyboardInterrupt:
+        pass
+    finally:
+        demux.close()
+
+
+if __name__ == "__main__":
+    main()
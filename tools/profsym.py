@@ -0,0 +1,124 @@
+#!/usr/bin/env python3
+"""profsym.py - Symbolise kacchiOS profiler dumps against kernel.elf.
+
+`profile dump` prints the sample histogram on the console:
+
+    PROF-BEGIN hz=<rate> samples=<n> dropped=<n>
+    PROF <count> <pid> <eip> [<caller> ...]
+    PROF-END
+
+Each line is one distinct sample: the interrupted EIP, followed by return
+addresses when the kernel unwinds the stack. Idle time is charged to
+the null process, PID 0; PID -1 only occurs for samples taken before
+process_manager_initialize. This script maps addresses to
+functions with `nm` and prints a flat profile; --folded writes one line
+per stack in the folded format used by flamegraph.pl and speedscope:
+
+    pid 1;process_a;busy_loop 42
+
+Usage:
+    profsym.py console.log
+    profsym.py console.log --elf kernel.elf --folded prof.folded
+"""
+import argparse
+import bisect
+import os
+import subprocess
+import sys
+
+
+def load_symbols(elf, nm):
+    """Sorted (address, name) pairs for the text symbols in elf."""
+    out = subprocess.run([nm, "-n", "--defined-only", elf],
+                         capture_output=True, text=True, check=True).stdout
+    symbols = []
+    for line in out.splitlines():
+        parts = line.split()
+        if len(parts) == 3 and parts[1] in "tTwW":
+            symbols.append((int(parts[0], 16), parts[2]))
+    return symbols
+
+
+class Symboliser:
+    def __init__(self, symbols):
+        self.addrs = [a for a, _ in symbols]
+        self.names = [n for _, n in symbols]
+
+    def name(self, addr):
+        i = bisect.bisect_right(self.addrs, addr) - 1
+        return self.names[i] if i >= 0 else f"0x{addr:08x}"
+
+
+def parse_dump(path):
+    """Return (header, samples): samples as (count, pid, [eip, callers...])."""
+    header = {}
+    samples = []
+    inside = False
+    with open(path, "r", errors="replace") as log:
+        for line in log:
+            line = line.strip()
+            if line.startswith("PROF-BEGIN"):
+                header = dict(f.split("=", 1) for f in line.split()[1:] if "=" in f)
+                samples = []
+                inside = True
+            elif line == "PROF-END":
+                inside = False
+            elif inside and line.startswith("PROF "):
+                parts = line.split()
+                try:
+                    addrs = [int(a, 16) for a in parts[3:]]
+                    samples.append((int(parts[1]), int(parts[2]), addrs))
+                except (ValueError, IndexError):
+                    print(f"profsym: malformed line: {line}", file=sys.stderr)
+    return header, samples
+
+
+def process_label(pid):
+    return "kernel" if pid < 0 else f"pid {pid}"
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("log", help="console log holding a profile dump (the last one is used)")
+    parser.add_argument("--elf", default="kernel.elf", help="kernel image (default: kernel.elf)")
+    parser.add_argument("--nm", default=os.environ.get("NM", "nm"), help="nm to run")
+    parser.add_argument("--folded", help="write folded stacks to this file")
+    parser.add_argument("--top", type=int, default=25, help="functions in the flat profile")
+    args = parser.parse_args()
+
+    header, samples = parse_dump(args.log)
+    if not samples:
+        print(f"profsym: no profile dump in {args.log}", file=sys.stderr)
+        return 1
+    sym = Symboliser(load_symbols(args.elf, args.nm))
+
+    total = sum(count for count, _, _ in samples)
+    self_counts = {}
+    for count, _, addrs in samples:
+        leaf = sym.name(addrs[0])
+        self_counts[leaf] = self_counts.get(leaf, 0) + count
+
+    print(f"{total} samples at {header.get('hz', '?')} Hz, "
+          f"{header.get('dropped', '0')} dropped")
+    print(f"{'samples':>8} {'%':>6}  function")
+    ranked = sorted(self_counts.items(), key=lambda kv: -kv[1])
+    for name, count in ranked[:args.top]:
+        print(f"{count:8d} {100.0 * count / total:6.2f}  {name}")
+
+    if args.folded:
+        folded = {}
+        for count, pid, addrs in samples:
+            # Return addresses point past the call; look up the call itself
+            names = [sym.name(addrs[0])] + [sym.name(a - 1) for a in addrs[1:]]
+            frames = [process_label(pid)] + names[::-1]
+            key = ";".join(frames)
+            folded[key] = folded.get(key, 0) + count
+        with open(args.folded, "w") as out:
+            for key, count in sorted(folded.items()):
+                out.write(f"{key} {count}\n")
+        print(f"profsym: {len(folded)} stacks written to {args.folded}")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())